@@ -1,6 +1,14 @@
 PLATFORM = lpc17xx
 JTAG = stlink
-USER_TESTS +=
+USER_TESTS += source/drivers/test/st7735_test.cpp
+USER_TESTS += source/graphics/test/text_renderer_test.cpp
+USER_TESTS += source/utility/test/spsc_ring_test.cpp
+USER_TESTS += source/graphics/test/framebuffer_test.cpp
+USER_TESTS += source/utility/test/histogram_test.cpp
+USER_TESTS += source/utility/test/library_index_test.cpp
+USER_TESTS += source/utility/test/metadata_parser_test.cpp
+USER_TESTS += source/utility/test/seek_table_test.cpp
+USER_TESTS += source/utility/test/seek_index_test.cpp
 
 purge-flash:
 	make purge
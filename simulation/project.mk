@@ -0,0 +1,2 @@
+PLATFORM = linux
+USER_TESTS +=
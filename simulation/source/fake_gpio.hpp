@@ -0,0 +1,94 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+
+#include "L1_Peripheral/gpio.hpp"
+
+/// A GPIO pin that exists only in memory, used to connect drivers to the
+/// behavioral device models of the host simulation.
+///
+/// The driver side uses the regular sjsu::Gpio interface. The model side
+/// drives input pins with Drive(), which runs the interrupt attached by the
+/// driver on a matching edge, and observes output pins with OnChange().
+class FakeGpio final : public sjsu::Gpio
+{
+ public:
+  using ChangeCallback = std::function<void(bool)>;
+
+  void SetDirection(Direction direction) const override
+  {
+    direction_ = direction;
+  }
+
+  void Set(State output) const override
+  {
+    Update(output == State::kHigh);
+  }
+
+  void Toggle() const override
+  {
+    Update(!state_);
+  }
+
+  bool Read() const override
+  {
+    return state_;
+  }
+
+  void AttachInterrupt(sjsu::InterruptCallback callback,
+                       Edge edge) const override
+  {
+    interrupt_ = callback;
+    edge_      = edge;
+  }
+
+  void DetachInterrupt() const override
+  {
+    interrupt_ = nullptr;
+  }
+
+  /// Drives the level of the pin from a device model, as if the device were
+  /// driving an input pin.
+  void Drive(bool level) const
+  {
+    Update(level);
+  }
+
+  /// Registers a callback run by a device model whenever the level of the pin
+  /// changes, for example to watch a chip select.
+  void OnChange(ChangeCallback callback) const
+  {
+    on_change_ = callback;
+  }
+
+ private:
+  void Update(bool level) const
+  {
+    const bool kPrevious = state_.exchange(level);
+    if (kPrevious == level)
+    {
+      return;
+    }
+
+    if (on_change_)
+    {
+      on_change_(level);
+    }
+
+    const bool kIsMatchingEdge =
+        edge_ == Edge::kEdgeBoth ||
+        (level && edge_ == Edge::kEdgeRising) ||
+        (!level && edge_ == Edge::kEdgeFalling);
+    if (interrupt_ && kIsMatchingEdge)
+    {
+      interrupt_();
+    }
+  }
+
+  mutable Direction direction_ = Direction::kInput;
+  mutable std::atomic<bool> state_ = false;
+  mutable sjsu::InterruptCallback interrupt_;
+  mutable Edge edge_ = Edge::kEdgeBoth;
+  mutable ChangeCallback on_change_;
+};
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "L1_Peripheral/spi.hpp"
+#include "utility/enum.hpp"
+
+/// A device attached to a FakeSpi bus.
+class SimulatedSpiDevice
+{
+ public:
+  /// Called for every frame clocked on the bus. Devices that are not selected
+  /// must ignore the frame and return 0.
+  ///
+  /// @param data The frame sent by the controller.
+  /// @param bits The number of bits in the frame.
+  /// @returns The frame sent back by the device.
+  virtual uint16_t Exchange(uint16_t data, uint8_t bits) = 0;
+};
+
+/// A SPI peripheral that forwards frames to simulated devices instead of
+/// hardware.
+class FakeSpi final : public sjsu::Spi
+{
+ public:
+  static constexpr size_t kMaxDevices = 4;
+
+  /// Attaches a device to the bus. Devices decide for themselves whether they
+  /// are selected by watching their chip select pins.
+  void Attach(SimulatedSpiDevice & device)
+  {
+    devices_[device_count_++] = &device;
+  }
+
+  void Initialize() const override {}
+
+  uint16_t Transfer(uint16_t data) const override
+  {
+    uint16_t response = 0;
+    for (size_t i = 0; i < device_count_; i++)
+    {
+      response |= devices_[i]->Exchange(data, bits_);
+    }
+    return response;
+  }
+
+  void SetDataSize(DataSize size) const override
+  {
+    // DataSize::kFour is the first enumerator.
+    bits_ = static_cast<uint8_t>(sjsu::Value(size) + 4);
+  }
+
+  void SetClock(units::frequency::hertz_t,
+                bool = false,
+                bool = false) const override
+  {
+  }
+
+ private:
+  std::array<SimulatedSpiDevice *, kMaxDevices> devices_ = {};
+  size_t device_count_                                  = 0;
+  mutable uint8_t bits_                                 = 8;
+};
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+#include "L2_HAL/memory/sd.hpp"
+#include "utility/log.hpp"
+
+/// Storage backed by a raw disk image file on the host, standing in for the SD
+/// card so FatFs reads the same file system the card would hold.
+///
+/// An image can be created with, for example:
+///
+///   dd if=/dev/zero of=sdcard.img bs=1M count=64
+///   mkfs.vfat sdcard.img
+///   mcopy -i sdcard.img *.mp3 ::/
+class ImageStorage final : public sjsu::Storage
+{
+ public:
+  /// Size of a block, in bytes, matching the SD card.
+  static constexpr size_t kBlockSize = 512;
+
+  /// @param path Path of the disk image on the host.
+  explicit ImageStorage(const char * path) : path_(path) {}
+
+  Type GetMemoryType() override
+  {
+    return Type::kSD;
+  }
+
+  void Initialize() override
+  {
+    file_ = std::fopen(path_, "r+b");
+    if (file_ == nullptr)
+    {
+      sjsu::LogError("Failed to open disk image %s", path_);
+      return;
+    }
+    std::fseek(file_, 0, SEEK_END);
+    size_ = static_cast<size_t>(std::ftell(file_));
+  }
+
+  bool IsMediaPresent() override
+  {
+    return file_ != nullptr;
+  }
+
+  void Enable() override {}
+
+  bool IsReadOnly() override
+  {
+    return false;
+  }
+
+  units::data::byte_t GetCapacity() override
+  {
+    return units::data::byte_t(static_cast<double>(size_));
+  }
+
+  units::data::byte_t GetBlockSize() override
+  {
+    return units::data::byte_t(kBlockSize);
+  }
+
+  void Erase(uint32_t, size_t) override {}
+
+  void Write(uint32_t block_address, const void * data, size_t size) override
+  {
+    Seek(block_address);
+    std::fwrite(data, 1, size, file_);
+  }
+
+  void Read(uint32_t block_address, void * data, size_t size) override
+  {
+    Seek(block_address);
+    const size_t kRead = std::fread(data, 1, size, file_);
+    if (kRead < size)
+    {
+      std::fill_n(static_cast<uint8_t *>(data) + kRead, size - kRead, 0);
+    }
+  }
+
+  void Disable() override
+  {
+    if (file_ != nullptr)
+    {
+      std::fclose(file_);
+      file_ = nullptr;
+    }
+  }
+
+ private:
+  void Seek(uint32_t block_address)
+  {
+    std::fseek(file_,
+               static_cast<long>(block_address * uint64_t{ kBlockSize }),
+               SEEK_SET);
+  }
+
+  const char * const path_;
+  std::FILE * file_ = nullptr;
+  size_t size_      = 0;
+};
@@ -0,0 +1,134 @@
+#include <cstdlib>
+
+#include "L0_Platform/startup.hpp"
+#include "L3_Application/fatfs.hpp"
+#include "L3_Application/task_scheduler.hpp"
+#include "utility/log.hpp"
+
+#include "../../source/drivers/spi_bus.hpp"
+#include "../../source/drivers/vs1053b.hpp"
+#include "../../source/tasks/audio_data_buffer_task.hpp"
+#include "../../source/tasks/mp3_player_task.hpp"
+#include "../../source/tasks/playback_benchmark_task.hpp"
+#include "../../source/tasks/seek_index_task.hpp"
+#include "../../source/utility/pipeline_config.hpp"
+#include "fake_gpio.hpp"
+#include "fake_spi.hpp"
+#include "image_storage.hpp"
+#include "simulation_report_task.hpp"
+#include "vs1053_model.hpp"
+
+// private namespace
+namespace
+{
+/// Disk image used in place of the SD card, can be overridden with the
+/// BLOCKBOOMBOX_SD_IMAGE environment variable.
+const char * GetImagePath()
+{
+  const char * path = std::getenv("BLOCKBOOMBOX_SD_IMAGE");
+  return (path != nullptr) ? path : "sdcard.img";
+}
+
+FakeSpi spi0;
+
+// -----------------------------------------------------------------------------
+//                                MP3 Decoder
+// -----------------------------------------------------------------------------
+
+FakeGpio dreq;
+FakeGpio rst;
+FakeGpio cs;
+FakeGpio dcs;
+SpiBus spi0_bus(spi0);
+Vs1053b mp3_decoder(spi0_bus,
+                    {
+                        .rst  = rst,
+                        .cs   = cs,
+                        .dcs  = dcs,
+                        .dreq = dreq,
+                    });
+Vs1053Model mp3_decoder_model({
+    .rst  = rst,
+    .cs   = cs,
+    .dcs  = dcs,
+    .dreq = dreq,
+});
+
+// -----------------------------------------------------------------------------
+//                                  SD Card
+// -----------------------------------------------------------------------------
+
+ImageStorage sd_card(GetImagePath());
+
+// -----------------------------------------------------------------------------
+//                                  Tasks
+// -----------------------------------------------------------------------------
+
+/// Block length and depth of the audio pipeline.
+using Pipeline = DefaultPipelineConfig;
+static_assert(Pipeline::kSdiBurstLength == Vs1053b::kSdiChunkSize);
+
+sjsu::rtos::TaskScheduler task_scheduler;
+Pipeline::BlockStorage audio_block_storage;
+Mp3PlayerTask<Pipeline> mp3_player_task(mp3_decoder, audio_block_storage);
+AudioDataBufferTask<Pipeline> audio_buffer_task(mp3_player_task);
+AudioDataDecodeTask<Pipeline> decoder_task(mp3_player_task);
+SeekIndexTask seek_index_task(mp3_player_task.GetSeekIndex());
+PlaybackBenchmarkTask<Pipeline> playback_benchmark_task(mp3_player_task,
+                                                  mp3_decoder,
+                                                  audio_buffer_task,
+                                                  decoder_task);
+SimulationReportTask<Pipeline> report_task(
+    mp3_decoder_model,
+    decoder_task);
+}  // namespace
+
+/// Host simulation of the playback pipeline. The firmware's tasks and drivers
+/// run unmodified on the host FreeRTOS port, with the decoder and SD card
+/// replaced by the models in this directory.
+int main()
+{
+  sjsu::LogDebug("Starting Simulation");
+
+  sjsu::InitializePlatform();
+
+  spi0.Attach(mp3_decoder_model);
+
+  sd_card.Initialize();
+  // Register and mount FatFs
+  FATFS fat_fs;
+  if (!sjsu::RegisterFatFsDrive(&sd_card))
+  {
+    return -1;
+  }
+  if (f_mount(&fat_fs, "", 0) != 0)
+  {
+    sjsu::LogError("Failed to mount disk image %s", GetImagePath());
+    return -2;
+  }
+
+  mp3_decoder.Initialize();
+  mp3_decoder.SetVolume(0.8f);
+  mp3_decoder.EnableDreqInterrupt();
+
+  // Play the library once so that the simulation ends.
+  mp3_player_task.SetRepeat(false);
+
+  task_scheduler.AddTask(&mp3_decoder_model);
+  // Setting BLOCKBOOMBOX_BENCHMARK plays the benchmark corpus of the disk
+  // image instead of its song list.
+  if (std::getenv("BLOCKBOOMBOX_BENCHMARK") != nullptr)
+  {
+    // The player only carries out the benchmark's commands.
+    mp3_player_task.SetAutoPlay(false);
+    task_scheduler.AddTask(&playback_benchmark_task);
+  }
+  task_scheduler.AddTask(&mp3_player_task);
+  task_scheduler.AddTask(&audio_buffer_task);
+  task_scheduler.AddTask(&decoder_task);
+  task_scheduler.AddTask(&seek_index_task);
+  task_scheduler.AddTask(&report_task);
+  task_scheduler.Start();
+
+  return 0;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdlib>
+
+#include "L3_Application/task_scheduler.hpp"
+#include "utility/log.hpp"
+
+#include "../../source/tasks/audio_data_buffer_task.hpp"
+#include "vs1053_model.hpp"
+
+/// Periodically logs the state of the simulated decoder and ends the
+/// simulation with a summary once the stream has been fully decoded.
+template <typename Pipeline>
+class SimulationReportTask final : public sjsu::rtos::Task<1024>
+{
+ public:
+  /// Interval between reports.
+  static constexpr TickType_t kReportPeriod = pdMS_TO_TICKS(1000);
+  /// Number of reports without any new SDI data, with the decoder FIFO empty,
+  /// after which playback is considered finished.
+  static constexpr uint32_t kIdleReportLimit = 3;
+
+  SimulationReportTask(const Vs1053Model & model,
+                       const AudioDataDecodeTask<Pipeline> & decoder_task)
+      : Task("SimulationReportTask", sjsu::rtos::Priority::kLow),
+        model_(model),
+        decoder_task_(decoder_task)
+  {
+  }
+
+  bool Run() override
+  {
+    vTaskDelay(kReportPeriod);
+
+    const auto & statistics           = model_.GetStatistics();
+    const uint32_t kPipelineUnderruns = decoder_task_.GetUnderrunCount();
+    sjsu::LogInfo("FIFO %zu/%zu B @ %lu bps, decoded %llu B, %lu underruns, "
+                  "%lu pipeline underruns, %lu overflows",
+                  model_.GetFill(),
+                  Vs1053Model::kFifoSize,
+                  static_cast<unsigned long>(model_.GetBitrate()),
+                  static_cast<unsigned long long>(statistics.bytes_decoded),
+                  static_cast<unsigned long>(statistics.underruns),
+                  static_cast<unsigned long>(kPipelineUnderruns),
+                  static_cast<unsigned long>(statistics.overflows));
+
+    const bool kIsIdle = statistics.bytes_received > 0 &&
+                         statistics.bytes_received == last_bytes_received_ &&
+                         model_.GetFill() == 0;
+    idle_reports_        = kIsIdle ? idle_reports_ + 1 : 0;
+    last_bytes_received_ = statistics.bytes_received;
+
+    if (idle_reports_ >= kIdleReportLimit)
+    {
+      sjsu::LogInfo("Simulation finished: %llu B decoded, max FIFO fill %zu B, "
+                    "%lu underruns, %lu pipeline underruns, %lu overflows, "
+                    "max gap %lu ms, %lu streams started",
+                    static_cast<unsigned long long>(statistics.bytes_decoded),
+                    statistics.max_fill,
+                    static_cast<unsigned long>(statistics.underruns),
+                    static_cast<unsigned long>(kPipelineUnderruns),
+                    static_cast<unsigned long>(statistics.overflows),
+                    static_cast<unsigned long>(statistics.max_gap_ms),
+                    static_cast<unsigned long>(
+                        decoder_task_.GetTelemetry().streams_started));
+      std::exit(EXIT_SUCCESS);
+    }
+    return true;
+  }
+
+ private:
+  const Vs1053Model & model_;
+  const AudioDataDecodeTask<Pipeline> & decoder_task_;
+  uint64_t last_bytes_received_ = 0;
+  uint32_t idle_reports_        = 0;
+};
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "utility/enum.hpp"
+
+#include "../../source/drivers/st7735.hpp"
+#include "fake_gpio.hpp"
+#include "fake_spi.hpp"
+
+/// Behavioral model of the display RAM of a ST7735 for host tests.
+///
+/// The model implements the address window commands (CASET, RASET), RAMWR and
+/// COLMOD. Pixels written after RAMWR fill the window like the controller
+/// with the MV bit of MADCTL clear: the column address varies fastest, then
+/// the row address. The write position is kept while the chip select is
+/// high, so a stream paused to release the bus resumes where it left off.
+/// Other commands are accepted and ignored.
+///
+/// @see 9.1 Display Data RAM in the ST7735S datasheet
+///
+/// @tparam kColumns Number of columns of the display RAM.
+/// @tparam kRows Number of rows of the display RAM.
+template <size_t kColumns, size_t kRows>
+class St7735Model final : public SimulatedSpiDevice
+{
+ public:
+  struct Pins_t
+  {
+    const FakeGpio & cs;
+    const FakeGpio & dc;
+  };
+
+  explicit St7735Model(Pins_t pins) : pins_(pins) {}
+
+  uint16_t Exchange(uint16_t data, uint8_t bits) override
+  {
+    if (pins_.cs.Read())
+    {
+      return 0;
+    }
+
+    if (!pins_.dc.Read())
+    {
+      command_         = static_cast<St7735::Command>(data);
+      parameter_count_ = 0;
+      if (command_ == St7735::Command::kRamWrite)
+      {
+        column_      = start_column_;
+        row_         = start_row_;
+        pixel_bytes_ = 0;
+      }
+      return 0;
+    }
+
+    if (command_ == St7735::Command::kRamWrite && bits == 16)
+    {
+      WritePixel(data);
+      return 0;
+    }
+
+    for (int shift = bits - 8; shift >= 0; shift -= 8)
+    {
+      ReceiveData(static_cast<uint8_t>(data >> shift));
+    }
+    return 0;
+  }
+
+  /// @returns The RGB565 value of the pixel at a column and row of the
+  ///          display RAM.
+  uint16_t GetPixel(size_t column, size_t row) const
+  {
+    return ram_[row * kColumns + column];
+  }
+
+  /// @returns The number of pixels written since the model was created.
+  size_t GetPixelCount() const
+  {
+    return pixel_count_;
+  }
+
+ private:
+  void ReceiveData(uint8_t data)
+  {
+    switch (command_)
+    {
+      case St7735::Command::kSetColumnAddress:
+        ReceiveAddress(data, &start_column_, &end_column_);
+        break;
+      case St7735::Command::kSetRowAddress:
+        ReceiveAddress(data, &start_row_, &end_row_);
+        break;
+      case St7735::Command::kSetPixelFormat:
+        pixel_format_ = static_cast<St7735::PixelFormat>(data & 0x07);
+        break;
+      case St7735::Command::kRamWrite: ReceivePixelByte(data); break;
+      default: break;
+    }
+    parameter_count_++;
+  }
+
+  /// CASET and RASET take the start and end address, most significant byte
+  /// first.
+  void ReceiveAddress(uint8_t data, size_t * start, size_t * end)
+  {
+    size_t * address = (parameter_count_ < 2) ? start : end;
+    if (parameter_count_ % 2 == 0)
+    {
+      *address = 0;
+    }
+    *address = (*address << 8) | data;
+  }
+
+  void ReceivePixelByte(uint8_t data)
+  {
+    pixel_[pixel_bytes_++] = data;
+    if (pixel_format_ == St7735::PixelFormat::kRgb565 && pixel_bytes_ == 2)
+    {
+      WritePixel(static_cast<uint16_t>((pixel_[0] << 8) | pixel_[1]));
+      pixel_bytes_ = 0;
+    }
+    else if (pixel_bytes_ == 3)
+    {
+      WritePixel(graphics::Rgb565_t(graphics::Color_t{ .red   = pixel_[0],
+                                                       .green = pixel_[1],
+                                                       .blue  = pixel_[2] })
+                     .value);
+      pixel_bytes_ = 0;
+    }
+  }
+
+  void WritePixel(uint16_t value)
+  {
+    if (column_ < kColumns && row_ < kRows)
+    {
+      ram_[row_ * kColumns + column_] = value;
+    }
+    pixel_count_++;
+
+    if (++column_ > end_column_)
+    {
+      column_ = start_column_;
+      if (++row_ > end_row_)
+      {
+        row_ = start_row_;
+      }
+    }
+  }
+
+  const Pins_t pins_;
+  std::array<uint16_t, kColumns * kRows> ram_ = {};
+  St7735::Command command_                    = St7735::Command::kNoOp;
+  St7735::PixelFormat pixel_format_           = St7735::PixelFormat::kRgb666;
+  size_t parameter_count_                     = 0;
+  size_t start_column_                        = 0;
+  size_t end_column_                          = kColumns - 1;
+  size_t start_row_                           = 0;
+  size_t end_row_                             = kRows - 1;
+  size_t column_                              = 0;
+  size_t row_                                 = 0;
+  std::array<uint8_t, 3> pixel_               = {};
+  size_t pixel_bytes_                         = 0;
+  size_t pixel_count_                         = 0;
+};
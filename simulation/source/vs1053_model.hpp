@@ -0,0 +1,379 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "L3_Application/task_scheduler.hpp"
+#include "utility/enum.hpp"
+
+#include "../../source/drivers/vs1053b.hpp"
+#include "fake_gpio.hpp"
+#include "fake_spi.hpp"
+
+/// Behavioral model of a VS1053b for the host simulation.
+///
+/// SDI data fills a 2048 byte FIFO that is drained at the bitrate of the MP3
+/// frames found in the stream, and DREQ is driven high whenever at least 32
+/// bytes are free, like the real device. Data sent before the first frame
+/// header of a stream is discarded as it arrives. SCI reads and writes go to a
+/// register file that implements the parts of SCI_MODE, SCI_DECODE_TIME and
+/// SCI_HDAT0/1 used by the driver. The model does not decode any audio.
+///
+/// @see 7.4 Serial Protocol for Serial Command Interface (SPI / SCI)
+///      https://cdn-shop.adafruit.com/datasheets/vs1053.pdf#page=20
+class Vs1053Model final : public SimulatedSpiDevice,
+                          public sjsu::rtos::Task<1024>
+{
+ public:
+  /// Size of the device's stream buffer.
+  static constexpr size_t kFifoSize = 2048;
+  /// DREQ is high while at least this many bytes of the FIFO are free.
+  static constexpr size_t kDreqFreeBytes = 32;
+  /// Bitrate assumed until the first frame header is received.
+  static constexpr uint32_t kDefaultBitrate = 128'000;
+  /// Interval at which the FIFO is drained.
+  static constexpr TickType_t kDecodePeriod = 1;
+
+  struct Pins_t
+  {
+    const FakeGpio & rst;
+    const FakeGpio & cs;
+    const FakeGpio & dcs;
+    const FakeGpio & dreq;
+  };
+
+  struct Statistics_t
+  {
+    /// Number of SDI bytes received.
+    uint64_t bytes_received = 0;
+    /// Number of bytes drained from the FIFO.
+    uint64_t bytes_decoded = 0;
+    /// Number of times the FIFO ran empty while decoding. The end of each
+    /// stream counts as one, as does each gap between songs.
+    uint32_t underruns = 0;
+    /// Longest time in milliseconds the FIFO stayed empty before more data
+    /// arrived, such as between songs.
+    uint32_t max_gap_ms = 0;
+    /// Number of SDI bytes dropped because they were sent while the FIFO was
+    /// full, which means the driver did not respect DREQ.
+    uint32_t overflows = 0;
+    /// Highest number of bytes held by the FIFO.
+    size_t max_fill = 0;
+  };
+
+  explicit Vs1053Model(Pins_t pins)
+      : Task("Vs1053Model", sjsu::rtos::Priority::kHigh), pins_(pins)
+  {
+    pins_.rst.OnChange([this](bool level) {
+      if (level)
+      {
+        HardwareReset();
+      }
+      else
+      {
+        pins_.dreq.Drive(false);
+      }
+    });
+    pins_.cs.OnChange([this](bool) { sci_index_ = 0; });
+  }
+
+  bool Run() override
+  {
+    vTaskDelay(kDecodePeriod);
+
+    bool is_ready = false;
+    taskENTER_CRITICAL();
+    {
+      Decode(kDecodePeriod * portTICK_PERIOD_MS);
+      is_ready = IsReady();
+    }
+    taskEXIT_CRITICAL();
+
+    pins_.dreq.Drive(is_ready);
+    return true;
+  }
+
+  uint16_t Exchange(uint16_t data, uint8_t bits) override
+  {
+    if (!pins_.rst.Read())
+    {
+      return 0;
+    }
+
+    const bool kIsSciSelected = !pins_.cs.Read();
+    const bool kIsSdiSelected = !pins_.dcs.Read();
+    if (!kIsSciSelected && !kIsSdiSelected)
+    {
+      return 0;
+    }
+
+    uint16_t response = 0;
+    bool is_ready     = false;
+    taskENTER_CRITICAL();
+    {
+      for (int shift = bits - 8; shift >= 0; shift -= 8)
+      {
+        const uint8_t kByte = static_cast<uint8_t>(data >> shift);
+        response            = static_cast<uint16_t>(response << 8);
+        if (kIsSciSelected)
+        {
+          response |= ExchangeSci(kByte);
+        }
+        else
+        {
+          ReceiveSdi(kByte);
+        }
+      }
+      is_ready = IsReady();
+    }
+    taskEXIT_CRITICAL();
+
+    if (!is_ready)
+    {
+      pins_.dreq.Drive(false);
+    }
+    return response;
+  }
+
+  /// @returns The number of bytes waiting in the FIFO.
+  size_t GetFill() const
+  {
+    return fill_;
+  }
+
+  /// @returns The bitrate the FIFO is currently drained at.
+  uint32_t GetBitrate() const
+  {
+    return bitrate_;
+  }
+
+  const Statistics_t & GetStatistics() const
+  {
+    return statistics_;
+  }
+
+ private:
+  using SciRegister = Vs1053b::SciRegister;
+
+  static constexpr uint16_t kStatusVersion = 4 << 4;
+
+  /// Mask of the header bits that stay constant across the frames of a
+  /// stream: sync, version, layer and sample rate.
+  static constexpr uint32_t kStreamHeaderMask = 0xFFFE'0C00;
+
+  void HardwareReset()
+  {
+    taskENTER_CRITICAL();
+    {
+      registers_ = {};
+      registers_[sjsu::Value(SciRegister::kMode)] =
+          static_cast<uint16_t>(Vs1053b::SciModeRegister().Set(
+              Vs1053b::SciModeRegister::kSdiNewMask));
+      registers_[sjsu::Value(SciRegister::kStatus)] = kStatusVersion;
+      Flush();
+    }
+    taskEXIT_CRITICAL();
+    pins_.dreq.Drive(true);
+  }
+
+  /// Discards the stream, as done by a cancel or a software reset.
+  void Flush()
+  {
+    fill_          = 0;
+    bit_credit_    = 0;
+    stream_header_ = 0;
+    header_window_ = 0;
+    bitrate_       = kDefaultBitrate;
+    is_decoding_   = false;
+  }
+
+  bool IsReady() const
+  {
+    return kFifoSize - fill_ >= kDreqFreeBytes;
+  }
+
+  void Decode(uint32_t milliseconds)
+  {
+    if (sjsu::bit::Read(registers_[sjsu::Value(SciRegister::kMode)],
+                        Vs1053b::SciModeRegister::kCancelMask))
+    {
+      uint16_t & mode = registers_[sjsu::Value(SciRegister::kMode)];
+      mode = sjsu::bit::Clear(mode, Vs1053b::SciModeRegister::kCancelMask);
+      Flush();
+      return;
+    }
+
+    if (fill_ == 0)
+    {
+      if (is_decoding_)
+      {
+        statistics_.underruns++;
+        is_decoding_ = false;
+        is_in_gap_   = true;
+        gap_ms_      = 0;
+      }
+      else if (is_in_gap_)
+      {
+        gap_ms_ += milliseconds;
+      }
+      return;
+    }
+
+    // The silence after the last song never ends, so only gaps followed by
+    // more data are recorded.
+    if (is_in_gap_)
+    {
+      statistics_.max_gap_ms = std::max(statistics_.max_gap_ms, gap_ms_);
+      is_in_gap_             = false;
+    }
+    is_decoding_ = true;
+    decode_time_ms_ += milliseconds;
+    bit_credit_ += static_cast<uint64_t>(bitrate_) * milliseconds / 1000;
+
+    const size_t kDecoded = static_cast<size_t>(
+        std::min<uint64_t>(bit_credit_ / 8, fill_));
+    bit_credit_ -= kDecoded * 8;
+    fill_ -= kDecoded;
+    statistics_.bytes_decoded += kDecoded;
+  }
+
+  void ReceiveSdi(uint8_t byte)
+  {
+    if (fill_ == kFifoSize)
+    {
+      statistics_.overflows++;
+      return;
+    }
+    statistics_.bytes_received++;
+    FindFrameHeader(byte);
+    // Until a stream's first frame header is found, the decoder discards the
+    // data as fast as it arrives, as with the end fill after a cancel.
+    if (stream_header_ == 0)
+    {
+      return;
+    }
+    fill_++;
+    statistics_.max_fill = std::max(statistics_.max_fill, fill_);
+  }
+
+  /// Tracks the bitrate of the stream from the headers of its frames.
+  ///
+  /// @see http://www.mp3-tech.org/programmer/frame_header.html
+  void FindFrameHeader(uint8_t byte)
+  {
+    // Layer III bitrates in kbps, indexed by [is MPEG-1][bitrate index].
+    static constexpr uint16_t kBitrates[2][16] = {
+      { 0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160, 0 },
+      { 0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 0 },
+    };
+
+    header_window_ = (header_window_ << 8) | byte;
+
+    const uint32_t kHeader         = header_window_;
+    const uint32_t kVersion        = (kHeader >> 19) & 0b11;
+    const uint32_t kLayer          = (kHeader >> 17) & 0b11;
+    const uint32_t kBitrateIndex   = (kHeader >> 12) & 0b1111;
+    const uint32_t kSampleRateCode = (kHeader >> 10) & 0b11;
+
+    const bool kIsHeader = (kHeader >> 21) == 0x7FF && kVersion != 0b01 &&
+                           kLayer == 0b01 && kBitrateIndex != 0 &&
+                           kBitrateIndex != 0b1111 && kSampleRateCode != 0b11;
+    if (!kIsHeader)
+    {
+      return;
+    }
+
+    // Lock onto the first header to reject sync patterns in audio data.
+    if (stream_header_ == 0)
+    {
+      stream_header_ = kHeader;
+    }
+    if ((kHeader & kStreamHeaderMask) != (stream_header_ & kStreamHeaderMask))
+    {
+      return;
+    }
+
+    bitrate_ = kBitrates[kVersion == 0b11][kBitrateIndex] * 1000;
+    registers_[sjsu::Value(SciRegister::kHDat1)] =
+        static_cast<uint16_t>(kHeader >> 16);
+    registers_[sjsu::Value(SciRegister::kHDat0)] =
+        static_cast<uint16_t>(kHeader);
+  }
+
+  /// Handles one byte of a SCI transaction: operation, address, then the
+  /// 16-bit register value most significant byte first.
+  uint8_t ExchangeSci(uint8_t byte)
+  {
+    uint8_t response = 0;
+    switch (sci_index_)
+    {
+      case 0: sci_operation_ = byte; break;
+      case 1: sci_address_ = byte & 0xF; break;
+      case 2:
+        sci_value_ = static_cast<uint16_t>(byte << 8);
+        response   = static_cast<uint8_t>(ReadSci(sci_address_) >> 8);
+        break;
+      case 3:
+        sci_value_ = static_cast<uint16_t>(sci_value_ | byte);
+        response   = static_cast<uint8_t>(ReadSci(sci_address_));
+        if (sci_operation_ == sjsu::Value(Vs1053b::Operation::kWrite))
+        {
+          WriteSci(sci_address_, sci_value_);
+        }
+        break;
+    }
+    sci_index_ = (sci_index_ + 1) % 4;
+    return response;
+  }
+
+  uint16_t ReadSci(uint8_t address) const
+  {
+    if (address == sjsu::Value(SciRegister::kDecodeTime))
+    {
+      return static_cast<uint16_t>(decode_time_ms_ / 1000);
+    }
+    return registers_[address];
+  }
+
+  void WriteSci(uint8_t address, uint16_t value)
+  {
+    switch (static_cast<SciRegister>(address))
+    {
+      case SciRegister::kMode:
+        if (sjsu::bit::Read(value, Vs1053b::SciModeRegister::kResetMask))
+        {
+          value = sjsu::bit::Clear(value, Vs1053b::SciModeRegister::kResetMask);
+          Flush();
+        }
+        break;
+      case SciRegister::kDecodeTime: decode_time_ms_ = value * 1000; break;
+      case SciRegister::kStatus: value |= kStatusVersion; break;
+      case SciRegister::kHDat0:
+      case SciRegister::kHDat1: return;
+      default: break;
+    }
+    registers_[address] = value;
+  }
+
+  const Pins_t pins_;
+
+  std::array<uint16_t, 16> registers_ = {};
+  uint8_t sci_index_                  = 0;
+  uint8_t sci_operation_              = 0;
+  uint8_t sci_address_                = 0;
+  uint16_t sci_value_                 = 0;
+
+  size_t fill_             = 0;
+  uint64_t bit_credit_     = 0;
+  uint32_t bitrate_        = kDefaultBitrate;
+  uint32_t header_window_  = 0;
+  uint32_t stream_header_  = 0;
+  uint32_t decode_time_ms_ = 0;
+  uint32_t gap_ms_         = 0;
+  bool is_decoding_        = false;
+  bool is_in_gap_          = false;
+
+  Statistics_t statistics_;
+};
@@ -7,6 +7,17 @@
 class AudioDecoder
 {
  public:
+  /// The format of the stream being decoded.
+  struct StreamInfo_t
+  {
+    /// Bitrate of the latest frame in bits per second.
+    uint32_t bitrate;
+    /// Sample rate in Hz.
+    uint32_t sample_rate;
+    /// MPEG audio layer, 1 to 3.
+    uint8_t layer;
+  };
+
   /// Initialize the device for use.
   virtual void Initialize() const = 0;
 
@@ -16,6 +27,14 @@ class AudioDecoder
   /// Enable the device to be ready to decode audio data.
   virtual void Enable() const = 0;
 
+  /// Finish decoding the current stream, so that a stream of a different
+  /// format can follow without resetting the device.
+  virtual void EndStream() const = 0;
+
+  /// Discard the audio held by the device and end the current stream, so that
+  /// the data sent next is heard immediately.
+  virtual void Cancel() const = 0;
+
   /// Pause audio decoding.
   virtual void Pause() const = 0;
 
@@ -34,4 +53,10 @@ class AudioDecoder
   /// @param percentage Volume percentage ranging from 0.0 to 1.0, where 1.0 is
   ///                   100 percent.
   virtual void SetVolume(float percentage) const = 0;
+
+  /// Reads the format of the stream being decoded.
+  ///
+  /// @param info Set to the format.
+  /// @returns False if the device has not decoded a frame of the stream.
+  virtual bool GetStreamInfo(StreamInfo_t * info) const = 0;
 };
@@ -0,0 +1,198 @@
+#pragma once
+
+#include "L0_Platform/lpc17xx/LPC17xx.h"
+#include "L1_Peripheral/interrupt.hpp"
+#include "L1_Peripheral/lpc17xx/system_controller.hpp"
+#include "L3_Application/task_scheduler.hpp"
+#include "utility/bit.hpp"
+
+#include "spi_dma.hpp"
+
+/// Transmits data over a LPC17xx SSP peripheral using a GPDMA channel.
+///
+/// @see 31. LPC17xx General Purpose DMA (GPDMA) controller
+///      https://www.nxp.com/docs/en/user-guide/UM10360.pdf#page=592
+class Lpc17xxSspDma final : public SpiDma
+{
+ public:
+  /// @see Table 543. DMA Connections
+  ///      https://www.nxp.com/docs/en/user-guide/UM10360.pdf#page=595
+  enum class Request : uint8_t
+  {
+    kSsp0Transmit = 0,
+    kSsp1Transmit = 2,
+  };
+
+  /// @see Table 564. Channel Control registers
+  ///      https://www.nxp.com/docs/en/user-guide/UM10360.pdf#page=608
+  struct ChannelControl
+  {
+    static constexpr auto kTransferSize     = sjsu::bit::MaskFromRange(0, 11);
+    static constexpr auto kSourceBurst      = sjsu::bit::MaskFromRange(12, 14);
+    static constexpr auto kDestinationBurst = sjsu::bit::MaskFromRange(15, 17);
+    static constexpr auto kSourceIncrement  = sjsu::bit::MaskFromRange(26);
+    static constexpr auto kTerminalCount    = sjsu::bit::MaskFromRange(31);
+  };
+
+  /// @see Table 565. Channel Configuration registers
+  ///      https://www.nxp.com/docs/en/user-guide/UM10360.pdf#page=609
+  struct ChannelConfig
+  {
+    static constexpr auto kEnable         = sjsu::bit::MaskFromRange(0);
+    static constexpr auto kDestination    = sjsu::bit::MaskFromRange(6, 10);
+    static constexpr auto kTransferType   = sjsu::bit::MaskFromRange(11, 13);
+    static constexpr auto kErrorInterrupt = sjsu::bit::MaskFromRange(14);
+    static constexpr auto kCountInterrupt = sjsu::bit::MaskFromRange(15);
+  };
+
+  /// The GPDMA can only reach the AHB SRAM banks, data stored in the local
+  /// SRAM must be transmitted by the CPU. The linker script places global
+  /// objects of the .bss.$RAM2 section in the first bank.
+  static constexpr uintptr_t kAhbRamStart = 0x2007'C000;
+  static constexpr uintptr_t kAhbRamEnd   = 0x2008'4000;
+  /// Size of each of the two AHB SRAM banks.
+  static constexpr size_t kAhbRamBankSize = 16 * 1024;
+
+  /// Maximum number of transfers of a single DMA transaction.
+  static constexpr size_t kMaxTransferSize = 4095;
+
+  /// Maximum time to wait for a transfer to complete.
+  static constexpr TickType_t kTransferTimeout = pdMS_TO_TICKS(10);
+
+  /// @param ssp The SSP peripheral the data is transmitted on.
+  /// @param request DMA request line of the SSP peripheral's transmit FIFO.
+  /// @param channel GPDMA channel number (0-7) used for the transfers.
+  ///
+  /// @note Only one instance may exist since the GPDMA channels share a single
+  ///       interrupt.
+  explicit Lpc17xxSspDma(sjsu::lpc17xx::LPC_SSP_TypeDef * ssp,
+                         Request request,
+                         uint8_t channel)
+      : ssp_(ssp), request_(request), channel_number_(channel)
+  {
+  }
+
+  void Initialize() const override
+  {
+    auto & system_controller = sjsu::SystemController::GetPlatformController();
+    system_controller.PowerUpPeripheral(
+        sjsu::lpc17xx::SystemController::Peripherals::kGpdma);
+
+    // Channel register blocks are spaced 0x20 bytes apart.
+    constexpr uintptr_t kChannelStride = 0x20;
+    channel_ = reinterpret_cast<sjsu::lpc17xx::LPC_GPDMACH_TypeDef *>(
+        reinterpret_cast<uintptr_t>(sjsu::lpc17xx::LPC_GPDMACH0) +
+        (kChannelStride * channel_number_));
+
+    constexpr uint32_t kDmaEnable = 0b1;
+    sjsu::lpc17xx::LPC_GPDMA->DMACConfig     = kDmaEnable;
+    sjsu::lpc17xx::LPC_GPDMA->DMACIntTCClear = ChannelMask();
+    sjsu::lpc17xx::LPC_GPDMA->DMACIntErrClr  = ChannelMask();
+
+    // Enable DMA requests for the SSP transmit FIFO.
+    constexpr uint32_t kTransmitDmaEnable = 0b10;
+    ssp_->DMACR                           = kTransmitDmaEnable;
+
+    sjsu::InterruptController::GetPlatformController().Enable({
+        .interrupt_request_number = sjsu::lpc17xx::DMA_IRQn,
+        .interrupt_handler        = [this]() { HandleInterrupt(); },
+    });
+  }
+
+  bool CanTransmit(const uint8_t * data, size_t length) const override
+  {
+    const auto kAddress = reinterpret_cast<uintptr_t>(data);
+    return kAddress >= kAhbRamStart && kAddress + length <= kAhbRamEnd &&
+           length <= kMaxTransferSize &&
+           xTaskGetSchedulerState() == taskSCHEDULER_RUNNING;
+  }
+
+  bool Transmit(const uint8_t * data, size_t length) const override
+  {
+    if (!CanTransmit(data, length))
+    {
+      return false;
+    }
+
+    waiting_task_ = xTaskGetCurrentTaskHandle();
+
+    channel_->DMACCSrcAddr  = reinterpret_cast<uintptr_t>(data);
+    channel_->DMACCDestAddr = reinterpret_cast<uintptr_t>(&ssp_->DR);
+    channel_->DMACCLLI      = 0;
+
+    // Byte wide transfers in bursts of 4, which is half of the SSP FIFO.
+    constexpr uint32_t kBurstOfFour = 0b001;
+    channel_->DMACCControl =
+        sjsu::bit::Value<uint32_t>()
+            .Insert(static_cast<uint32_t>(length),
+                    ChannelControl::kTransferSize)
+            .Insert(kBurstOfFour, ChannelControl::kSourceBurst)
+            .Insert(kBurstOfFour, ChannelControl::kDestinationBurst)
+            .Set(ChannelControl::kSourceIncrement)
+            .Set(ChannelControl::kTerminalCount);
+
+    constexpr uint32_t kMemoryToPeripheral = 0b001;
+    channel_->DMACCConfig =
+        sjsu::bit::Value<uint32_t>()
+            .Insert(sjsu::Value(request_), ChannelConfig::kDestination)
+            .Insert(kMemoryToPeripheral, ChannelConfig::kTransferType)
+            .Set(ChannelConfig::kErrorInterrupt)
+            .Set(ChannelConfig::kCountInterrupt)
+            .Set(ChannelConfig::kEnable);
+
+    const bool kCompleted = ulTaskNotifyTake(pdTRUE, kTransferTimeout);
+    waiting_task_         = nullptr;
+
+    // The terminal count interrupt fires once the last byte is moved into the
+    // transmit FIFO, wait for it to be shifted out before returning so the
+    // caller can safely release the chip select.
+    constexpr uint32_t kReceiveNotEmpty = 1 << 2;
+    constexpr uint32_t kBusy            = 1 << 4;
+    while (ssp_->SR & kBusy)
+    {
+      continue;
+    }
+    // Discard the received bytes and clear the receive overrun flag.
+    while (ssp_->SR & kReceiveNotEmpty)
+    {
+      [[maybe_unused]] volatile uint32_t discard = ssp_->DR;
+    }
+    constexpr uint32_t kClearReceiveOverrun = 0b1;
+    ssp_->ICR                               = kClearReceiveOverrun;
+
+    if (!kCompleted)
+    {
+      channel_->DMACCConfig = 0;
+    }
+    return kCompleted;
+  }
+
+ private:
+  uint32_t ChannelMask() const
+  {
+    return 1 << channel_number_;
+  }
+
+  void HandleInterrupt() const
+  {
+    if (!(sjsu::lpc17xx::LPC_GPDMA->DMACIntStat & ChannelMask()))
+    {
+      return;
+    }
+    sjsu::lpc17xx::LPC_GPDMA->DMACIntTCClear = ChannelMask();
+    sjsu::lpc17xx::LPC_GPDMA->DMACIntErrClr  = ChannelMask();
+
+    if (waiting_task_ != nullptr)
+    {
+      BaseType_t higher_priority_task_woken = pdFALSE;
+      vTaskNotifyGiveFromISR(waiting_task_, &higher_priority_task_woken);
+      portYIELD_FROM_ISR(higher_priority_task_woken);
+    }
+  }
+
+  sjsu::lpc17xx::LPC_SSP_TypeDef * ssp_;
+  const Request request_;
+  const uint8_t channel_number_;
+  mutable sjsu::lpc17xx::LPC_GPDMACH_TypeDef * channel_ = nullptr;
+  mutable volatile TaskHandle_t waiting_task_          = nullptr;
+};
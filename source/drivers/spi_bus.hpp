@@ -0,0 +1,243 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "L1_Peripheral/spi.hpp"
+#include "L3_Application/task_scheduler.hpp"
+#include "utility/time.hpp"
+
+#include "spi_dma.hpp"
+
+/// Wraps a SPI peripheral shared by several devices.
+///
+/// Devices must Acquire() the bus before a transaction and Release() it
+/// afterwards. The bus tracks its current configuration so that switching
+/// between devices only reprograms the settings that differ.
+///
+/// High priority clients (the audio decoder) are always served before low
+/// priority ones. Low priority clients performing long transfers (display
+/// redraws) are expected to poll IsContended() and briefly release the bus
+/// so that audio data is never held up for more than a short chunk.
+class SpiBus
+{
+ public:
+  enum class Priority : uint8_t
+  {
+    kLow,
+    kHigh,
+  };
+
+  /// The settings a device requires of the bus.
+  struct Configuration_t
+  {
+    units::frequency::hertz_t frequency;
+    sjsu::Spi::DataSize data_size = sjsu::Spi::DataSize::kEight;
+
+    bool operator==(const Configuration_t & other) const
+    {
+      return frequency == other.frequency && data_size == other.data_size;
+    }
+
+    bool operator!=(const Configuration_t & other) const
+    {
+      return !(*this == other);
+    }
+  };
+
+  /// Counters used to measure the cost of bus transactions.
+  struct Statistics_t
+  {
+    /// Number of times the clock or data size was reprogrammed.
+    uint32_t reconfigurations = 0;
+    /// Number of calls made to transmit data, a DMA transfer counts as one.
+    uint32_t transfer_calls = 0;
+    /// Number of payload bytes written with Write().
+    uint32_t bytes_written = 0;
+  };
+
+  /// @param spi The SPI peripheral.
+  /// @param dma Optional DMA transmitter for the peripheral, used by Write()
+  ///            when the bus is configured for 8-bit frames.
+  explicit SpiBus(sjsu::Spi & spi, const SpiDma * dma = nullptr)
+      : spi_(spi), dma_(dma)
+  {
+    mutex_ = xSemaphoreCreateMutexStatic(&mutex_buffer_);
+  }
+
+  /// Initializes the peripheral with an initial configuration. Only the first
+  /// device to initialize the bus initializes the peripheral, later calls
+  /// just apply the configuration.
+  void Initialize(const Configuration_t & configuration) const
+  {
+    if (is_initialized_)
+    {
+      Configure(configuration);
+      return;
+    }
+
+    spi_.SetClock(configuration.frequency);
+    spi_.SetDataSize(configuration.data_size);
+    spi_.Initialize();
+    if (dma_ != nullptr)
+    {
+      dma_->Initialize();
+    }
+    configuration_  = configuration;
+    is_initialized_ = true;
+  }
+
+  /// Takes ownership of the bus and applies the device's configuration. Low
+  /// priority clients wait for all pending high priority clients first.
+  ///
+  /// @param configuration The configuration required by the device.
+  /// @param priority The priority of the device.
+  void Acquire(const Configuration_t & configuration, Priority priority) const
+  {
+    if (xTaskGetSchedulerState() == taskSCHEDULER_RUNNING)
+    {
+      if (priority == Priority::kHigh)
+      {
+        high_priority_waiting_++;
+        xSemaphoreTake(mutex_, portMAX_DELAY);
+        high_priority_waiting_--;
+      }
+      else
+      {
+        while (high_priority_waiting_ > 0)
+        {
+          vTaskDelay(1);
+        }
+        xSemaphoreTake(mutex_, portMAX_DELAY);
+      }
+    }
+    Configure(configuration);
+  }
+
+  /// Releases ownership of the bus, yielding to a waiting high priority client.
+  void Release() const
+  {
+    if (xTaskGetSchedulerState() == taskSCHEDULER_RUNNING)
+    {
+      xSemaphoreGive(mutex_);
+      if (high_priority_waiting_ > 0)
+      {
+        taskYIELD();
+      }
+    }
+  }
+
+  /// @returns True if a high priority client is waiting for the bus. Low
+  ///          priority clients should release the bus as soon as possible.
+  bool IsContended() const
+  {
+    return high_priority_waiting_ > 0;
+  }
+
+  /// @returns True if no task currently owns the bus. Only valid when called
+  ///          from an interrupt, during which no task can take the bus.
+  bool IsAvailableFromIsr() const
+  {
+    return xSemaphoreGetMutexHolderFromISR(mutex_) == nullptr;
+  }
+
+  /// Reprograms the peripheral if the configuration differs from the current
+  /// one. Callers must own the bus.
+  void Configure(const Configuration_t & configuration) const
+  {
+    if (configuration.frequency != configuration_.frequency)
+    {
+      spi_.SetClock(configuration.frequency);
+      statistics_.reconfigurations++;
+    }
+    if (configuration.data_size != configuration_.data_size)
+    {
+      spi_.SetDataSize(configuration.data_size);
+      statistics_.reconfigurations++;
+    }
+    configuration_ = configuration;
+  }
+
+  /// @returns The current configuration of the bus.
+  const Configuration_t & GetConfiguration() const
+  {
+    return configuration_;
+  }
+
+  /// @returns True if Write() can transmit a block using DMA, which requires
+  ///          a DMA transmitter that can reach the block.
+  bool CanWriteWithDma(const uint8_t * data, size_t length) const
+  {
+    return dma_ != nullptr && dma_->CanTransmit(data, length);
+  }
+
+  /// Transfers a single frame of the currently configured size.
+  uint16_t Transfer(uint16_t data) const
+  {
+    statistics_.transfer_calls++;
+    return spi_.Transfer(data);
+  }
+
+  /// Writes a block of bytes, discarding the received data.
+  ///
+  /// With 16-bit frames two bytes are sent per frame, most significant byte
+  /// first. With 8-bit frames the block is sent in a single DMA transfer when
+  /// a DMA transmitter is available.
+  ///
+  /// @param data The bytes to write.
+  /// @param length Number of bytes to write.
+  /// @param allow_dma False when called from an interrupt.
+  void Write(const uint8_t * data, size_t length, bool allow_dma = true) const
+  {
+    statistics_.bytes_written += length;
+
+    if (configuration_.data_size == sjsu::Spi::DataSize::kSixteen)
+    {
+      for (; length >= 2; data += 2, length -= 2)
+      {
+        Transfer(static_cast<uint16_t>((data[0] << 8) | data[1]));
+      }
+      if (length == 0)
+      {
+        return;
+      }
+      // A trailing odd byte has to be sent as an 8-bit frame.
+      Configure({ .frequency = configuration_.frequency,
+                  .data_size = sjsu::Spi::DataSize::kEight });
+    }
+
+    if (allow_dma && dma_ != nullptr && dma_->Transmit(data, length))
+    {
+      statistics_.transfer_calls++;
+      return;
+    }
+
+    for (size_t i = 0; i < length; i++)
+    {
+      Transfer(data[i]);
+    }
+  }
+
+  /// @returns The counters collected since the last reset.
+  const Statistics_t & GetStatistics() const
+  {
+    return statistics_;
+  }
+
+  /// Clears the collected counters.
+  void ResetStatistics() const
+  {
+    statistics_ = Statistics_t{};
+  }
+
+ private:
+  const sjsu::Spi & spi_;
+  const SpiDma * const dma_;
+  StaticSemaphore_t mutex_buffer_;
+  SemaphoreHandle_t mutex_;
+  mutable std::atomic<uint32_t> high_priority_waiting_ = 0;
+  mutable bool is_initialized_                         = false;
+  mutable Configuration_t configuration_ = { .frequency = 0_MHz };
+  mutable Statistics_t statistics_;
+};
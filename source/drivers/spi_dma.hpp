@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/// An interface for transmitting blocks of data over a SPI bus using DMA.
+class SpiDma
+{
+ public:
+  /// Initialize the DMA channel and enable DMA requests on the SPI bus. Must
+  /// be called after the SPI bus has been initialized.
+  virtual void Initialize() const = 0;
+
+  /// @param data Pointer to the data to transmit.
+  /// @param length Number of bytes to transmit.
+  /// @returns True if Transmit() can send the data with DMA, for example
+  ///          because the data lies in memory the DMA controller can read.
+  virtual bool CanTransmit(const uint8_t * data, size_t length) const = 0;
+
+  /// Transmits a block of data and blocks the calling task until the transfer
+  /// is complete. Other tasks are free to run while the transfer is in
+  /// progress. Received data is discarded.
+  ///
+  /// @param data Pointer to the data to transmit.
+  /// @param length Number of bytes to transmit.
+  /// @returns False if the transfer could not be performed with DMA, in which
+  ///          case the caller should transmit the data itself.
+  virtual bool Transmit(const uint8_t * data, size_t length) const = 0;
+};
@@ -7,9 +7,12 @@
 #include "utility/enum.hpp"
 #include "utility/log.hpp"
 
+#include "../graphics/display.hpp"
+#include "../graphics/framebuffer.hpp"
 #include "../graphics/graphics.hpp"
+#include "spi_bus.hpp"
 
-class St7735 final : public sjsu::PixelDisplay
+class St7735 final : public sjsu::PixelDisplay, public graphics::Display
 {
  public:
   enum class Command : uint8_t
@@ -26,29 +29,51 @@ class St7735 final : public sjsu::PixelDisplay
     kDisplayOff        = 0x28,
     kDisplayOn         = 0x29,
     kSetWriteDirection = 0x36,
+    kSetPixelFormat    = 0x3A,
   };
 
-  /// @param spi           SPI bus used to control the device.
+  /// Interface pixel formats selected with the COLMOD command.
+  enum class PixelFormat : uint8_t
+  {
+    /// 16 bits per pixel, sent as a single 16-bit frame.
+    kRgb565 = 0x05,
+    /// 18 bits per pixel, sent as three bytes with the lower 2 bits ignored.
+    kRgb666 = 0x06,
+  };
+
+  /// Number of pixels written between checks for a waiting high priority bus
+  /// client. At 12 MHz this holds the bus for at most ~64us at a time.
+  static constexpr uint32_t kBusYieldInterval = 32;
+
+  /// @param bus           SPI bus used to control the device. The display is a
+  ///                      low priority client of the bus.
   /// @param spi_frequency Frequency of SPI, should be between 1Mhz - 12Mhz.
   /// @param rst_pin       Reset (active low).
   /// @param cs_pin        Chip select (active low).
   /// @param dc_pin        Data/Command select (active low).
   /// @param screen_width
   /// @param screen_height
-  explicit St7735(sjsu::Spi & spi,
+  /// @param framebuffer   Optional framebuffer of the same dimensions as the
+  ///                      screen. When provided, DrawPixel() draws into the
+  ///                      framebuffer and Update() sends only the regions that
+  ///                      changed to the display. Otherwise DrawPixel() draws
+  ///                      directly to the display.
+  explicit St7735(SpiBus & bus,
                   units::frequency::hertz_t spi_frequency,
                   sjsu::Gpio & rst_pin,
                   sjsu::Gpio & cs_pin,
                   sjsu::Gpio & dc_pin,
                   size_t screen_width,
-                  size_t screen_height)
-      : spi_(spi),
-        kSpiFrequency(spi_frequency),
+                  size_t screen_height,
+                  graphics::Framebuffer * framebuffer = nullptr)
+      : bus_(bus),
+        kBusConfiguration({ .frequency = spi_frequency }),
         rst_pin_(rst_pin),
         cs_pin_(cs_pin),
         dc_pin_(dc_pin),
         kScreenWidth(screen_width),
-        kScreenHeight(screen_height)
+        kScreenHeight(screen_height),
+        framebuffer_(framebuffer)
   {
   }
 
@@ -61,9 +86,7 @@ class St7735 final : public sjsu::PixelDisplay
     dc_pin_.SetAsOutput();
     dc_pin_.SetHigh();
 
-    spi_.SetClock(kSpiFrequency);
-    spi_.SetDataSize(sjsu::Spi::DataSize::kEight);
-    spi_.Initialize();
+    bus_.Initialize(kBusConfiguration);
 
     Reset();
   }
@@ -85,19 +108,31 @@ class St7735 final : public sjsu::PixelDisplay
 
   void Sleep(bool on = true)
   {
-    WriteCommand(on ? Command::kSleepIn : Command::kSleepOut);
+    AcquireBus();
+    {
+      WriteCommand(on ? Command::kSleepIn : Command::kSleepOut);
+    }
+    bus_.Release();
     sjsu::Delay(2ms);
   }
 
   void Enable() override
   {
-    WriteCommand(Command::kDisplayOn);
+    AcquireBus();
+    {
+      WriteCommand(Command::kDisplayOn);
+    }
+    bus_.Release();
     sjsu::Delay(100us);
   }
 
   void Disable() override
   {
-    WriteCommand(Command::kDisplayOff);
+    AcquireBus();
+    {
+      WriteCommand(Command::kDisplayOff);
+    }
+    bus_.Release();
     sjsu::Delay(100us);
   }
 
@@ -114,56 +149,192 @@ class St7735 final : public sjsu::PixelDisplay
     // the device is in sleep mode and display is off after a hardware reset
     Sleep(false);
     Enable();
+    // the pixel format resets to RGB666, restore the selected format before
+    // any pixels are sent
+    SetPixelFormat(pixel_format_);
     // set initial display to show a white screen
     Clear();
     // set orientation X-Y exchange
-    WriteCommand(Command::kSetWriteDirection);
-    constexpr uint8_t kOrientation = 0x84;
-    WriteData(kOrientation);
+    AcquireBus();
+    {
+      WriteCommand(Command::kSetWriteDirection);
+      constexpr uint8_t kOrientation = 0x84;
+      WriteData(kOrientation);
+    }
+    bus_.Release();
+  }
+
+  /// Selects the format pixels are sent in. RGB565 sends each pixel as a
+  /// single 16-bit frame instead of three bytes.
+  void SetPixelFormat(PixelFormat format)
+  {
+    AcquireBus();
+    {
+      WriteCommand(Command::kSetPixelFormat);
+      WriteData(sjsu::Value(format));
+    }
+    bus_.Release();
+    pixel_format_ = format;
+  }
+
+  PixelFormat GetPixelFormat() const
+  {
+    return pixel_format_;
   }
 
   void Clear() override
   {
     FillFrame(graphics::Frame_t(0, 0, kScreenWidth, kScreenHeight),
               graphics::kWhite);
+    if (framebuffer_ != nullptr)
+    {
+      framebuffer_->Reset(graphics::kWhite);
+    }
   }
 
   void FillFrame(graphics::Frame_t frame, graphics::Color_t color) const
   {
-    SetDrawAddress(frame);
-    WriteColor(color, frame.size.width * frame.size.height);
+    const graphics::Rgb565_t kPacked(color);
+    AcquireBus();
+    {
+      SetDrawAddress(frame);
+      WritePixels(frame,
+                  [color](uint16_t, uint16_t) { return color; },
+                  [kPacked](uint16_t, uint16_t) { return kPacked; });
+    }
+    bus_.Release();
   }
 
   void DrawBitmap(graphics::Frame_t frame, const graphics::Color_t ** bitmap)
   {
-    SetDrawAddress(frame);
-    for (uint16_t y = 0; y < frame.size.width; y++)
+    const auto kPixelAt = [bitmap](uint16_t x, uint16_t y) {
+      return bitmap[y][x];
+    };
+    AcquireBus();
     {
-      for (uint16_t x = 0; x < frame.size.height; x++)
-      {
-        WriteColor(bitmap[x][y]);
-      }
+      SetDrawAddress(frame);
+      WritePixels(frame,
+                  kPixelAt,
+                  [&kPixelAt](uint16_t x, uint16_t y) {
+                    return graphics::Rgb565_t(kPixelAt(x, y));
+                  });
     }
+    bus_.Release();
   }
 
-  void DrawPixel([[maybe_unused]] int32_t x,
-                 [[maybe_unused]] int32_t y,
-                 [[maybe_unused]] Color_t color) override
+  /// Draws a bitmap of pre-packed RGB565 pixels stored row by row. In RGB565
+  /// mode the pixels are sent as they are without any conversion.
+  void DrawBitmap(graphics::Frame_t frame, const graphics::Rgb565_t * bitmap)
   {
+    const size_t kWidth = frame.size.width;
+    DrawPixels(frame, [bitmap, kWidth](uint16_t x, uint16_t y) {
+      return bitmap[y * kWidth + x];
+    });
   }
 
+  /// Draws pixels generated on the fly into a frame using a single address
+  /// window, so images can be drawn without storing them in full.
+  ///
+  /// @param frame The frame to draw into.
+  /// @param pixel_at Returns the pixel at (x, y) of the frame as a Rgb565_t.
+  ///                 Called exactly once per pixel, column by column from
+  ///                 the left, top to bottom within each column.
+  template <typename PixelSource>
+  void DrawPixels(graphics::Frame_t frame, PixelSource pixel_at) const
+  {
+    AcquireBus();
+    {
+      SetDrawAddress(frame);
+      WritePixels(
+          frame,
+          [&pixel_at](uint16_t x, uint16_t y) {
+            return pixel_at(x, y).ToColor();
+          },
+          [&pixel_at](uint16_t x, uint16_t y) { return pixel_at(x, y); });
+    }
+    bus_.Release();
+  }
+
+  graphics::Framebuffer * GetFramebuffer() override
+  {
+    return framebuffer_;
+  }
+
+  void DrawColumns(graphics::Frame_t frame, ColumnSource & source) override
+  {
+    DrawPixels(frame, [&source](uint16_t x, uint16_t y) {
+      return source.GetPixel(x, y);
+    });
+  }
+
+  void DrawPixel(int32_t x, int32_t y, Color_t color) override
+  {
+    const graphics::Color_t kColor = {
+      .red = color.red, .green = color.green, .blue = color.blue
+    };
+
+    if (framebuffer_ != nullptr)
+    {
+      framebuffer_->SetPixel(x, y, kColor);
+      return;
+    }
+
+    if (x < 0 || y < 0 || static_cast<size_t>(x) >= kScreenWidth ||
+        static_cast<size_t>(y) >= kScreenHeight)
+    {
+      return;
+    }
+    FillFrame(graphics::Frame_t(static_cast<uint16_t>(x),
+                                static_cast<uint16_t>(y),
+                                1,
+                                1),
+              kColor);
+  }
+
+  /// Sends the regions of the framebuffer that changed since the last update
+  /// to the display, using a single address window per region.
   void Update() override
   {
-    // TODO: implement
+    if (framebuffer_ == nullptr || !framebuffer_->IsDirty())
+    {
+      return;
+    }
+
+    AcquireBus();
+    {
+      for (size_t i = 0; i < framebuffer_->GetDirtyCount(); i++)
+      {
+        const graphics::Frame_t kFrame = framebuffer_->GetDirtyFrame(i);
+        const auto kPixelAt = [this, &kFrame](uint16_t x, uint16_t y) {
+          return framebuffer_->GetPixel(kFrame.origin.x + x,
+                                        kFrame.origin.y + y);
+        };
+
+        SetDrawAddress(kFrame);
+        WritePixels(kFrame,
+                    kPixelAt,
+                    [&kPixelAt](uint16_t x, uint16_t y) {
+                      return graphics::Rgb565_t(kPixelAt(x, y));
+                    });
+      }
+    }
+    bus_.Release();
+
+    framebuffer_->ClearDirty();
   }
 
  private:
+  void AcquireBus() const
+  {
+    bus_.Acquire(kBusConfiguration, SpiBus::Priority::kLow);
+  }
+
   void WriteCommand(Command command) const
   {
     dc_pin_.SetLow();
     cs_pin_.SetLow();
     {
-      spi_.Transfer(sjsu::Value(command));
+      bus_.Transfer(sjsu::Value(command));
     }
     cs_pin_.SetHigh();
     dc_pin_.SetHigh();
@@ -173,7 +344,7 @@ class St7735 final : public sjsu::PixelDisplay
   {
     cs_pin_.SetLow();
     {
-      spi_.Transfer(data);
+      bus_.Transfer(data);
     }
     cs_pin_.SetHigh();
   }
@@ -182,8 +353,8 @@ class St7735 final : public sjsu::PixelDisplay
   {
     cs_pin_.SetLow();
     {
-      spi_.Transfer(static_cast<uint8_t>(data >> 8));
-      spi_.Transfer(data & 0xFF);
+      bus_.Transfer(static_cast<uint8_t>(data >> 8));
+      bus_.Transfer(data & 0xFF);
     }
     cs_pin_.SetHigh();
   }
@@ -201,23 +372,77 @@ class St7735 final : public sjsu::PixelDisplay
     WriteCommand(Command::kRamWrite);
   }
 
-  void WriteColor(graphics::Color_t color, uint32_t repeat_count = 1) const
+  /// Streams pixels into the address window of a frame with the chip select
+  /// held low for the whole window.
+  ///
+  /// SetDrawAddress() maps the frame's y to the display's columns, so the
+  /// display fills the window column by column, top to bottom: y varies
+  /// fastest. This is the only place that order is known, every draw path
+  /// hands in pixel sources addressed by coordinates.
+  ///
+  /// If the audio decoder is waiting for the bus, the chip select is briefly
+  /// released along with the bus. The display keeps its RAM write position
+  /// while its chip select is high, so the stream resumes where it left off.
+  ///
+  /// @param frame The frame whose address window was set.
+  /// @param color_at Returns the pixel at (x, y) of the frame as a Color_t,
+  ///                 used in RGB666 mode.
+  /// @param packed_at Returns the pixel at (x, y) of the frame as a Rgb565_t,
+  ///                  used in RGB565 mode.
+  template <typename ColorSource, typename PackedSource>
+  void WritePixels(graphics::Frame_t frame,
+                   ColorSource color_at,
+                   PackedSource packed_at) const
   {
-    while (repeat_count > 0)
+    const uint32_t kHeight = frame.size.height;
+    const uint32_t kCount  = frame.size.width * kHeight;
+    const bool kIsPacked = (pixel_format_ == PixelFormat::kRgb565);
+    const SpiBus::Configuration_t kPixelConfiguration = {
+      .frequency = kBusConfiguration.frequency,
+      .data_size = kIsPacked ? sjsu::Spi::DataSize::kSixteen
+                             : sjsu::Spi::DataSize::kEight,
+    };
+
+    bus_.Configure(kPixelConfiguration);
+    cs_pin_.SetLow();
+    for (uint32_t i = 0; i < kCount; i++)
     {
-      WriteData(color.red);
-      WriteData(color.green);
-      WriteData(color.blue);
-      repeat_count--;
+      const auto kX = static_cast<uint16_t>(i / kHeight);
+      const auto kY = static_cast<uint16_t>(i % kHeight);
+      if (kIsPacked)
+      {
+        bus_.Transfer(packed_at(kX, kY).value);
+      }
+      else
+      {
+        const graphics::Color_t kColor = color_at(kX, kY);
+        bus_.Transfer(kColor.red);
+        bus_.Transfer(kColor.green);
+        bus_.Transfer(kColor.blue);
+      }
+
+      if ((i + 1) % kBusYieldInterval == 0 && bus_.IsContended())
+      {
+        cs_pin_.SetHigh();
+        bus_.Release();
+        bus_.Acquire(kPixelConfiguration, SpiBus::Priority::kLow);
+        cs_pin_.SetLow();
+      }
     }
+    cs_pin_.SetHigh();
+    // Commands and parameters are sent as bytes.
+    bus_.Configure(kBusConfiguration);
   }
 
-  const sjsu::Spi & spi_;
-  const units::frequency::hertz_t kSpiFrequency;
+  const SpiBus & bus_;
+  const SpiBus::Configuration_t kBusConfiguration;
   const sjsu::Gpio & rst_pin_;
   const sjsu::Gpio & cs_pin_;
   const sjsu::Gpio & dc_pin_;
 
   const size_t kScreenWidth;
   const size_t kScreenHeight;
+
+  graphics::Framebuffer * const framebuffer_;
+  PixelFormat pixel_format_ = PixelFormat::kRgb565;
 };
@@ -0,0 +1,148 @@
+#include <array>
+
+#include "L4_Testing/testing_frameworks.hpp"
+
+#include "../../../simulation/source/fake_gpio.hpp"
+#include "../../../simulation/source/fake_spi.hpp"
+#include "../../../simulation/source/st7735_model.hpp"
+#include "../../graphics/framebuffer.hpp"
+#include "../spi_bus.hpp"
+#include "../st7735.hpp"
+
+namespace
+{
+// A screen that is neither square nor evenly divisible, so that a transposed
+// or scrambled stream lands on the wrong pixels.
+constexpr size_t kScreenWidth  = 7;
+constexpr size_t kScreenHeight = 5;
+}  // namespace
+
+TEST_CASE("Testing St7735")
+{
+  FakeSpi spi;
+  FakeGpio rst;
+  FakeGpio cs;
+  FakeGpio dc;
+  cs.SetHigh();
+  dc.SetHigh();
+  SpiBus bus(spi);
+  graphics::StaticFramebuffer<kScreenWidth, kScreenHeight> framebuffer;
+  St7735 display(
+      bus, 1_MHz, rst, cs, dc, kScreenWidth, kScreenHeight, &framebuffer);
+  // SetDrawAddress() sends the frame's y as the column address and x as the
+  // row address.
+  St7735Model<kScreenHeight, kScreenWidth> model({ .cs = cs, .dc = dc });
+  spi.Attach(model);
+  display.SetPixelFormat(St7735::PixelFormat::kRgb565);
+
+  const auto kPixelAt = [&model](size_t x, size_t y) {
+    return model.GetPixel(y, x);
+  };
+  // A distinct value for every pixel of the screen.
+  const auto kPattern = [](size_t x, size_t y) {
+    return static_cast<uint16_t>(((y + 1) << 8) | (x + 1));
+  };
+
+  SECTION("DrawBitmap() places a row by row bitmap in a non-square frame")
+  {
+    constexpr size_t kWidth  = 3;
+    constexpr size_t kHeight = 2;
+    std::array<graphics::Rgb565_t, kWidth * kHeight> bitmap;
+    for (size_t y = 0; y < kHeight; y++)
+    {
+      for (size_t x = 0; x < kWidth; x++)
+      {
+        bitmap[y * kWidth + x] = kPattern(x, y);
+      }
+    }
+
+    display.DrawBitmap(graphics::Frame_t(2, 1, kWidth, kHeight),
+                       bitmap.data());
+
+    CHECK(model.GetPixelCount() == kWidth * kHeight);
+    for (size_t y = 0; y < kHeight; y++)
+    {
+      for (size_t x = 0; x < kWidth; x++)
+      {
+        CHECK(kPixelAt(2 + x, 1 + y) == kPattern(x, y));
+      }
+    }
+  }
+
+  SECTION("DrawPixels() asks for every pixel once, column by column")
+  {
+    constexpr size_t kWidth  = 4;
+    constexpr size_t kHeight = 3;
+    size_t calls             = 0;
+
+    display.DrawPixels(graphics::Frame_t(1, 2, kWidth, kHeight),
+                       [&](uint16_t x, uint16_t y) {
+                         CHECK(x == calls / kHeight);
+                         CHECK(y == calls % kHeight);
+                         calls++;
+                         return graphics::Rgb565_t(kPattern(x, y));
+                       });
+
+    CHECK(calls == kWidth * kHeight);
+    for (size_t y = 0; y < kHeight; y++)
+    {
+      for (size_t x = 0; x < kWidth; x++)
+      {
+        CHECK(kPixelAt(1 + x, 2 + y) == kPattern(x, y));
+      }
+    }
+  }
+
+  SECTION("DrawPixels() in RGB666 mode sends the same pixels as bytes")
+  {
+    constexpr size_t kWidth  = 3;
+    constexpr size_t kHeight = 2;
+    display.SetPixelFormat(St7735::PixelFormat::kRgb666);
+
+    display.DrawPixels(
+        graphics::Frame_t(0, 0, kWidth, kHeight),
+        [&](uint16_t x, uint16_t y) {
+          return graphics::Rgb565_t(kPattern(x, y));
+        });
+
+    for (size_t y = 0; y < kHeight; y++)
+    {
+      for (size_t x = 0; x < kWidth; x++)
+      {
+        CHECK(kPixelAt(x, y) == kPattern(x, y));
+      }
+    }
+  }
+
+  SECTION("Update() sends dirty regions of the framebuffer in place")
+  {
+    const graphics::Color_t kColors[] = {
+      graphics::kRed, graphics::kGreen, graphics::kBlue, graphics::kBlack
+    };
+    framebuffer.Reset(graphics::kWhite);
+    for (int32_t y = 1; y < 4; y++)
+    {
+      for (int32_t x = 2; x < 7; x++)
+      {
+        const graphics::Color_t kColor = kColors[(x + 2 * y) % 4];
+        display.DrawPixel(x,
+                          y,
+                          { .red   = kColor.red,
+                            .green = kColor.green,
+                            .blue  = kColor.blue });
+      }
+    }
+
+    display.Update();
+
+    CHECK_FALSE(framebuffer.IsDirty());
+    for (size_t y = 1; y < 4; y++)
+    {
+      for (size_t x = 2; x < 7; x++)
+      {
+        const graphics::Rgb565_t kExpected(kColors[(x + 2 * y) % 4]);
+        CHECK(kPixelAt(x, y) == kExpected.value);
+      }
+    }
+  }
+}
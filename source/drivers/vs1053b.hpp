@@ -1,11 +1,22 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
 #include "L1_Peripheral/gpio.hpp"
 #include "L1_Peripheral/spi.hpp"
+#include "L3_Application/task_scheduler.hpp"
 #include "utility/enum.hpp"
+#include "utility/log.hpp"
 #include "utility/time.hpp"
 
+#include "../utility/histogram.hpp"
+#include "../utility/spsc_ring.hpp"
 #include "audio_decoder.hpp"
+#include "spi_bus.hpp"
 
 /// Audio decoder capable of decoding various formats such as Ogg Vorbis, MP3,
 /// AAC, WMA, and MIDI.
@@ -90,17 +101,53 @@ class Vs1053b : public AudioDecoder
     sjsu::Gpio & dreq;
   };
 
-  // static constexpr uint16_t kSampleRateLut[4][4] = {
-  //   { 11025, 11025, 22050, 44100 },
-  //   { 12000, 12000, 24000, 48000 },
-  //   { 8000, 8000, 16000, 32000 },
-  //   { 0, 0, 0, 0 }
-  // };
+  /// Sample rates in Hz, indexed by the [sample rate][ID] fields of
+  /// SCI_HDAT0 and SCI_HDAT1. IDs 0 and 1 both mean MPEG-2.5.
+  static constexpr uint16_t kSampleRateLut[4][4] = {
+    { 11025, 11025, 22050, 44100 },
+    { 12000, 12000, 24000, 48000 },
+    { 8000, 8000, 16000, 32000 },
+    { 0, 0, 0, 0 }
+  };
+
+  /// Bitrates in kbps, indexed by [MPEG version and layer][bitrate field of
+  /// SCI_HDAT0]. MPEG-2 and MPEG-2.5 share their tables, as do their layers
+  /// II and III.
+  static constexpr uint16_t kBitrateLut[5][16] = {
+    // MPEG-1 layer I, II and III.
+    { 0, 32, 64, 96, 128, 160, 192, 224, 256, 288, 320, 352, 384, 416, 448 },
+    { 0, 32, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384 },
+    { 0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320 },
+    // MPEG-2 and MPEG-2.5 layer I, then II and III.
+    { 0, 32, 48, 56, 64, 80, 96, 112, 128, 144, 160, 176, 192, 224, 256 },
+    { 0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160 },
+  };
+
+  /// Number of SDI bytes after which the SPI cost per KB is logged.
+  static constexpr size_t kStatisticsInterval = 64 * 1024;
+
+  /// Time for the decoder to play its entire 2048 byte stream buffer at the
+  /// highest MP3 bitrate of 320 kbps.
+  static constexpr std::chrono::milliseconds kFifoDrainTime = 51ms;
 
-  /// @param spi The SPI bus used to drive the device.
+  /// Counters kept for the lifetime of the driver.
+  struct Telemetry_t
+  {
+    /// Time spent waiting for DREQ, only recorded when DREQ was low.
+    LatencyHistogram<> dreq_wait;
+    /// Estimated number of times the stream buffer ran empty mid-song: DREQ
+    /// was high after more than kFifoDrainTime without SDI data. May
+    /// overcount at low bitrates.
+    uint32_t fifo_empty_events = 0;
+  };
+
+  /// @param bus The SPI bus used to drive the device. When the bus has a DMA
+  ///            transmitter, SDI bursts are sent by DMA and the calling task
+  ///            sleeps until each burst is complete.
   /// @param pins The various controls pins for the devies.
-  explicit Vs1053b(sjsu::Spi & spi, ControlPins_t pins) : spi_(spi), pins_(pins)
+  explicit Vs1053b(SpiBus & bus, ControlPins_t pins) : bus_(bus), pins_(pins)
   {
+    resume_semaphore_ = xSemaphoreCreateBinaryStatic(&resume_semaphore_buffer_);
   }
 
   void Initialize() const override
@@ -131,9 +178,7 @@ class Vs1053b : public AudioDecoder
     //
     // Once the SCI_CLOCKF multiplier is set, the SPI clock can be changed to
     // faster speeds.
-    spi_.SetClock(3_MHz);
-    spi_.SetDataSize(sjsu::Spi::DataSize::kEight);
-    spi_.Initialize();
+    bus_.Initialize({ .frequency = 3_MHz });
 
     Reset();
 
@@ -156,14 +201,74 @@ class Vs1053b : public AudioDecoder
     write_speed_                              = kClki / 4;
   }
 
+  /// Maximum time to wait for DREQ before giving up on a transaction.
+  static constexpr std::chrono::milliseconds kDreqTimeout = 100ms;
+
+  /// Number of bytes the device is guaranteed to accept each time DREQ is
+  /// high.
+  static constexpr size_t kSdiChunkSize = 32;
+
+  /// Maximum number of bytes the DREQ interrupt sends from the feed ring
+  /// before returning, which bounds the time spent in the interrupt to about
+  /// 0.1 ms at 12 MHz. Bytes left in the ring are sent from task context the
+  /// next time the feeding task pushes data, which the interrupt wakes if it
+  /// is waiting for room.
+  static constexpr size_t kMaxIsrFeedLength = 4 * kSdiChunkSize;
+
+  /// Attaches a rising edge interrupt to the DREQ pin so that tasks waiting for
+  /// the device to become ready sleep instead of polling the pin.
+  ///
+  /// @note Must be called after Initialize().
+  void EnableDreqInterrupt() const
+  {
+    if (dreq_semaphore_ == nullptr)
+    {
+      dreq_semaphore_ = xSemaphoreCreateBinaryStatic(&dreq_semaphore_buffer_);
+    }
+    pins_.dreq.AttachInterrupt([this]() { HandleDreqInterrupt(); },
+                               sjsu::Gpio::Edge::kEdgeRising);
+  }
+
+  /// Routes all audio data passed to Buffer() through a lock-free ring that is
+  /// drained into SDI by the DREQ interrupt whenever the device can accept
+  /// more data.
+  ///
+  /// @param ring Ring used to hold the pending audio data. Buffer() must only
+  ///             be called from a single task once this is enabled.
+  void EnableIsrFeeding(SpscRing<uint8_t> & ring) const
+  {
+    if (space_semaphore_ == nullptr)
+    {
+      space_semaphore_ =
+          xSemaphoreCreateBinaryStatic(&space_semaphore_buffer_);
+    }
+    feed_ring_ = &ring;
+    EnableDreqInterrupt();
+  }
+
+  /// Waits for the device to assert DREQ. When the DREQ interrupt is enabled
+  /// the calling task sleeps until the pin rises, otherwise the pin is polled.
+  /// Any number of tasks may wait at once, each rising edge wakes them all.
+  ///
   /// @see Data Request Pin DREQ
   ///      https://cdn-shop.adafruit.com/datasheets/vs1053.pdf#page=16
-  void WaitForReadyStatus() const
+  ///
+  /// @param timeout Maximum time to wait.
+  /// @returns True if DREQ is high, false if the timeout expired.
+  bool WaitForReadyStatus(
+      std::chrono::milliseconds timeout = kDreqTimeout) const
   {
-    while (!pins_.dreq.Read())
+    if (pins_.dreq.Read())
     {
-      continue;
+      return true;
     }
+
+    const auto kStartTime = sjsu::Uptime();
+    const bool kIsReady   = WaitForDreq(timeout);
+    telemetry_.dreq_wait.Record(
+        std::chrono::duration_cast<std::chrono::microseconds>(sjsu::Uptime() -
+                                                              kStartTime));
+    return kIsReady;
   }
 
   /// Toggles the reset pin to perform a hardware reset.
@@ -197,35 +302,64 @@ class Vs1053b : public AudioDecoder
   /// Start audio decoding from 0:00.
   void Enable() const override
   {
-    Resume();
+    last_sdi_time_ = 0us;
+    ConfigureStream();
     // Automatic Resync selector
     WriteSci(SciRegister::kWRamAddr, 0x1E29);
     WriteSci(SciRegister::kWRam, 0x0000);
     ClearDecodeTime();
   }
 
-  /// Pause audio decoding. Note that when decoding is resumes, the audio will
-  /// be start from the point it was paused.
-  void Pause() const override
+  /// Finishes the current stream with the datasheet's end fill procedure: the
+  /// end fill byte is sent until the last frame has left the stream buffer,
+  /// then the stream is cancelled, which resets the decoder's state without a
+  /// software reset.
+  ///
+  /// Streams of the same format need not be ended, the decoder continues from
+  /// the last frame of one into the first frame of the next.
+  ///
+  /// @see 10.5.1 Playing a Whole File
+  ///      https://cdn-shop.adafruit.com/datasheets/vs1053.pdf
+  void EndStream() const override
   {
-    constexpr uint16_t kStreamModeCancel =
-        SciModeRegister::Default().Set(SciModeRegister::kCancelMask);
-    WriteSci(SciRegister::kMode, kStreamModeCancel);
+    const uint8_t kEndFillByte = ReadEndFillByte();
+    SendEndFill(kEndFillByte, kEndFillLength);
+    // Data still held by the feed ring would be cancelled along with the
+    // fill.
+    FlushFeedRing();
+    CancelStream(kEndFillByte);
+  }
 
-    while (!pins_.dreq.Read() ||
-           sjsu::bit::Read(ReadRegister(SciRegister::kMode),
-                           SciModeRegister::kCancelMask))
-    {
-      continue;
-    }
+  /// Discards the audio in the stream buffer with the datasheet's cancel
+  /// procedure, then flushes the decoder with the end fill byte so the next
+  /// data starts a clean stream.
+  ///
+  /// @see 10.5.2 Cancelling Playback
+  ///      https://cdn-shop.adafruit.com/datasheets/vs1053.pdf
+  void Cancel() const override
+  {
+    const uint8_t kEndFillByte = ReadEndFillByte();
+    CancelStream(kEndFillByte);
+    SendEndFill(kEndFillByte, kEndFillLength);
+  }
+
+  /// Pauses audio decoding by holding back the data sent with Buffer(). The
+  /// decoder stops once it has played the data it already holds, and resumes
+  /// from the same point.
+  ///
+  /// The datasheet has no pause command, a decoder starved of data simply
+  /// waits for more. When the feed ring is enabled the data in the ring is
+  /// played as well.
+  void Pause() const override
+  {
+    is_paused_ = true;
   }
 
-  /// Resume audio decoding.
+  /// Resumes audio decoding, waking the task blocked in Buffer().
   void Resume() const override
   {
-    constexpr uint16_t kAuDataOption = 0xAC45;
-    WriteSci(SciRegister::kMode, SciModeRegister::Default());
-    WriteSci(SciRegister::kAuData, kAuDataOption);
+    is_paused_ = false;
+    xSemaphoreGive(resume_semaphore_);
   }
 
   // Resets the current decode time to 0:00, this is done by writing 0x0 to the
@@ -236,19 +370,64 @@ class Vs1053b : public AudioDecoder
     WriteSci(SciRegister::kDecodeTime, 0x0000);
   }
 
-  /// Sends audio data to the decoder 32 bytes at a time.
+  /// Sends audio data to the decoder 32 bytes at a time. A trailing partial
+  /// chunk is sent as a shorter SDI write.
   ///
   /// @see 9.4 Serial Data Interface (SDI)
   ///      https://cdn-shop.adafruit.com/datasheets/vs1053.pdf#page=37
   ///
-  /// @note Need to wait for DREQ
+  /// @note Need to wait for DREQ, and blocks while paused.
   void Buffer(const uint8_t * data, size_t length) const override
   {
-    constexpr size_t kBufferSize = 32;
-    for (size_t i = 0; i < length / kBufferSize; i++)
+    while (is_paused_)
+    {
+      xSemaphoreTake(resume_semaphore_, portMAX_DELAY);
+    }
+    Send(data, length);
+  }
+
+  const Telemetry_t & GetTelemetry() const
+  {
+    return telemetry_;
+  }
+
+  /// @returns The SPI clock used for SDI writes.
+  units::frequency::hertz_t GetSdiFrequency() const
+  {
+    return write_speed_;
+  }
+
+  /// Decodes the frame header of the stream held in SCI_HDAT1 and SCI_HDAT0.
+  /// The bitrate is that of the latest frame, which varies from frame to
+  /// frame in variable bitrate songs.
+  ///
+  /// @see 9.6.9 SCI_HDAT0 and SCI_HDAT1 (RW)
+  ///      https://cdn-shop.adafruit.com/datasheets/vs1053.pdf#page=45
+  bool GetStreamInfo(StreamInfo_t * info) const override
+  {
+    const uint16_t kHeaderHigh = ReadRegister(SciRegister::kHDat1);
+    const uint16_t kHeaderLow  = ReadRegister(SciRegister::kHDat0);
+
+    // HDAT1 starts with the frame sync word only while MP3 is decoded.
+    const uint16_t kSync           = kHeaderHigh >> 5;
+    const uint8_t kId              = (kHeaderHigh >> 3) & 0b11;
+    const uint8_t kLayerField      = (kHeaderHigh >> 1) & 0b11;
+    const uint8_t kBitrateIndex    = kHeaderLow >> 12;
+    const uint8_t kSampleRateIndex = (kHeaderLow >> 10) & 0b11;
+    // Unlike the frame header, where ID 1 is reserved, the VS1053b reports
+    // MPEG-2.5 as either ID 0 or ID 1. Layer field 0 is reserved.
+    if (kSync != 0x7FF || kLayerField == 0)
     {
-      WriteSdi(data + (i * kBufferSize), kBufferSize);
+      return false;
     }
+
+    const bool kIsMpeg1    = (kId == 0b11);
+    const uint8_t kLayer   = static_cast<uint8_t>(4 - kLayerField);
+    const size_t kTable    = kIsMpeg1 ? kLayer - 1 : (kLayer == 1 ? 3 : 4);
+    info->bitrate          = kBitrateLut[kTable][kBitrateIndex] * 1000;
+    info->sample_rate      = kSampleRateLut[kSampleRateIndex][kId];
+    info->layer            = kLayer;
+    return info->bitrate != 0 && info->sample_rate != 0;
   }
 
   /// Sets the volume for both L and R audio channels.
@@ -263,11 +442,88 @@ class Vs1053b : public AudioDecoder
     // The VS_VOL register contains the 16-bit control for the volume where the
     // higher 8-bits is for the left channel and the lower 8-bits are for the
     // right channel.
-    uint16_t volume = static_cast<uint16_t>(difference << 8) | volume;
+    uint16_t volume = static_cast<uint16_t>(difference << 8) | difference;
     WriteSci(SciRegister::kVolume, volume);
   }
 
  private:
+  /// Selects the default stream mode and the sample rate reported before the
+  /// first frame is decoded.
+  void ConfigureStream() const
+  {
+    constexpr uint16_t kAuDataOption = 0xAC45;
+    WriteSci(SciRegister::kMode, SciModeRegister::Default());
+    WriteSci(SciRegister::kAuData, kAuDataOption);
+  }
+
+  /// Sends audio data to the decoder regardless of pausing, see Buffer().
+  void Send(const uint8_t * data, size_t length) const
+  {
+    if (feed_ring_ != nullptr)
+    {
+      BufferThroughRing(data, length);
+    }
+    else
+    {
+      if (last_sdi_time_ != 0us &&
+          sjsu::Uptime() - last_sdi_time_ > kFifoDrainTime &&
+          pins_.dreq.Read())
+      {
+        telemetry_.fifo_empty_events++;
+      }
+
+      for (size_t offset = 0; offset < length; offset += kSdiChunkSize)
+      {
+        WriteSdi(data + offset, std::min(kSdiChunkSize, length - offset));
+      }
+      last_sdi_time_ = sjsu::Uptime();
+    }
+
+    sdi_bytes_ += length;
+    if (sdi_bytes_ >= kStatisticsInterval)
+    {
+      LogBusStatistics();
+    }
+  }
+
+  /// Sleeps or polls until DREQ rises, see WaitForReadyStatus().
+  bool WaitForDreq(std::chrono::milliseconds timeout) const
+  {
+    if (dreq_semaphore_ != nullptr &&
+        xTaskGetSchedulerState() == taskSCHEDULER_RUNNING)
+    {
+      const TickType_t kTimeoutTicks = pdMS_TO_TICKS(timeout.count());
+      // A stale give from an earlier edge only causes one extra pin check.
+      while (!pins_.dreq.Read())
+      {
+        if (!xSemaphoreTake(dreq_semaphore_, kTimeoutTicks))
+        {
+          return pins_.dreq.Read();
+        }
+        if (pins_.dreq.Read())
+        {
+          // Several tasks may be waiting, such as the decode task sending
+          // data and another task reading a register, but an edge gives the
+          // semaphore once. Give it on so that the next waiter wakes too
+          // rather than sleeping until its timeout with DREQ already high.
+          xSemaphoreGive(dreq_semaphore_);
+          return true;
+        }
+      }
+      return true;
+    }
+
+    const auto kDeadline = sjsu::Uptime() + timeout;
+    while (!pins_.dreq.Read())
+    {
+      if (sjsu::Uptime() > kDeadline)
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
   /// Reads a desired SCI register.
   ///
   /// @param address The address of the SCI register to read.
@@ -276,17 +532,20 @@ class Vs1053b : public AudioDecoder
   {
     WaitForReadyStatus();
 
-    spi_.SetClock(read_speed_);
-
     uint16_t data = 0x0;
-    pins_.cs.SetLow();
+    bus_.Acquire({ .frequency = read_speed_,
+                   .data_size = sjsu::Spi::DataSize::kSixteen },
+                 SpiBus::Priority::kHigh);
     {
-      spi_.Transfer(sjsu::Value(Operation::kRead));
-      spi_.Transfer(sjsu::Value(address));
-      data = static_cast<uint16_t>(data | (spi_.Transfer(0x00) << 8));
-      data = data | spi_.Transfer(0x00);
+      pins_.cs.SetLow();
+      {
+        bus_.Transfer(SciHeader(Operation::kRead, address));
+        data = bus_.Transfer(0x0000);
+      }
+      pins_.cs.SetHigh();
     }
-    pins_.cs.SetHigh();
+    bus_.Release();
+    KickFeeder();
     return data;
   }
 
@@ -303,16 +562,19 @@ class Vs1053b : public AudioDecoder
   {
     WaitForReadyStatus();
 
-    spi_.SetClock(write_speed_);
-
-    pins_.cs.SetLow();
+    bus_.Acquire({ .frequency = write_speed_,
+                   .data_size = sjsu::Spi::DataSize::kSixteen },
+                 SpiBus::Priority::kHigh);
     {
-      spi_.Transfer(sjsu::Value(Operation::kWrite));
-      spi_.Transfer(sjsu::Value(address));
-      spi_.Transfer(static_cast<uint8_t>(data >> 8));
-      spi_.Transfer(data & 0xFF);
+      pins_.cs.SetLow();
+      {
+        bus_.Transfer(SciHeader(Operation::kWrite, address));
+        bus_.Transfer(data);
+      }
+      pins_.cs.SetHigh();
     }
-    pins_.cs.SetHigh();
+    bus_.Release();
+    KickFeeder();
   }
 
   /// Sends audio data byte(s) for decoding.
@@ -324,20 +586,213 @@ class Vs1053b : public AudioDecoder
   {
     WaitForReadyStatus();
 
-    spi_.SetClock(write_speed_);
+    bus_.Acquire(SdiConfiguration(bus_.CanWriteWithDma(data, length)),
+                 SpiBus::Priority::kHigh);
+    {
+      TransmitSdi(data, length);
+    }
+    bus_.Release();
+  }
+
+  /// Sends audio data without waiting for DREQ. The caller is responsible for
+  /// owning the bus and ensuring the device can accept the data.
+  ///
+  /// @param use_dma False when called from an interrupt, since a DMA transfer
+  ///                blocks the calling task until it completes.
+  void TransmitSdi(const uint8_t * data,
+                   size_t length,
+                   bool use_dma = true) const
+  {
+    const bool kUseDma = use_dma && bus_.CanWriteWithDma(data, length);
+    bus_.Configure(SdiConfiguration(kUseDma));
 
     pins_.dcs.SetLow();
     {
-      for (size_t i = 0; i < length; i++)
+      bus_.Write(data, length, kUseDma);
+    }
+    pins_.dcs.SetHigh();
+  }
+
+  /// @param use_dma True if the data will be sent with DMA.
+  /// @returns The bus configuration used for SDI writes.
+  SpiBus::Configuration_t SdiConfiguration(bool use_dma = false) const
+  {
+    // DMA transfers must use 8-bit frames since the GPDMA would send the
+    // bytes of a 16-bit frame in little endian order. Data the GPDMA cannot
+    // reach is sent by the CPU, where 16-bit frames halve the number of
+    // transfers.
+    return { .frequency = write_speed_,
+             .data_size = use_dma ? sjsu::Spi::DataSize::kEight
+                                  : sjsu::Spi::DataSize::kSixteen };
+  }
+
+  /// @returns The first 16-bit frame of a SCI transaction.
+  static constexpr uint16_t SciHeader(Operation operation, SciRegister address)
+  {
+    return static_cast<uint16_t>((sjsu::Value(operation) << 8) |
+                                 sjsu::Value(address));
+  }
+
+  /// Logs the number of SPI reconfigurations and transfer calls spent per KB
+  /// of audio data since the last log, then resets the counters.
+  void LogBusStatistics() const
+  {
+    const auto & statistics = bus_.GetStatistics();
+    const size_t kKilobytes = sdi_bytes_ / 1024;
+    sjsu::LogDebug("SPI per KB: %lu reconfigurations, %lu transfer calls",
+                   statistics.reconfigurations / kKilobytes,
+                   statistics.transfer_calls / kKilobytes);
+    bus_.ResetStatistics();
+    sdi_bytes_ = 0;
+  }
+
+  /// Pushes data into the feed ring, sleeping whenever the ring is full until
+  /// the DREQ interrupt has made room.
+  void BufferThroughRing(const uint8_t * data, size_t length) const
+  {
+    constexpr TickType_t kSpaceTimeout = 1;
+    while (length > 0)
+    {
+      const size_t kPushed = feed_ring_->Push(data, length);
+      data += kPushed;
+      length -= kPushed;
+
+      // DREQ may already be high, in which case no edge will arrive to start
+      // draining the newly pushed data.
+      KickFeeder();
+
+      if (length > 0)
       {
-        spi_.Transfer(data[i]);
+        xSemaphoreTake(space_semaphore_, kSpaceTimeout);
       }
     }
-    pins_.dcs.SetHigh();
   }
 
-  const sjsu::Spi & spi_;
+  /// Bytes of end fill that push the last frame through the stream buffer.
+  static constexpr size_t kEndFillLength = 2052;
+
+  /// @returns The byte to pad the end of a stream with.
+  uint8_t ReadEndFillByte() const
+  {
+    constexpr uint16_t kEndFillByteAddress = 0x1E06;
+    WriteSci(SciRegister::kWRamAddr, kEndFillByteAddress);
+    return static_cast<uint8_t>(ReadRegister(SciRegister::kWRam));
+  }
+
+  /// Sends a number of end fill bytes, even while paused, so that a paused
+  /// stream can be cancelled.
+  void SendEndFill(uint8_t end_fill_byte, size_t length) const
+  {
+    std::array<uint8_t, kSdiChunkSize> fill;
+    fill.fill(end_fill_byte);
+    for (size_t sent = 0; sent < length; sent += fill.size())
+    {
+      Send(fill.data(), std::min(fill.size(), length - sent));
+    }
+  }
+
+  /// Sets SM_CANCEL and sends end fill bytes until the decoder has taken the
+  /// cancel, which it does within 2048 bytes. Resets the decoder otherwise.
+  void CancelStream(uint8_t end_fill_byte) const
+  {
+    constexpr size_t kCancelFillLength = 2048;
+    constexpr uint16_t kStreamModeCancel =
+        SciModeRegister::Default().Set(SciModeRegister::kCancelMask);
+    WriteSci(SciRegister::kMode, kStreamModeCancel);
+
+    for (size_t sent = 0; sent < kCancelFillLength; sent += kSdiChunkSize)
+    {
+      SendEndFill(end_fill_byte, kSdiChunkSize);
+      FlushFeedRing();
+      if (!sjsu::bit::Read(ReadRegister(SciRegister::kMode),
+                           SciModeRegister::kCancelMask))
+      {
+        return;
+      }
+    }
+
+    sjsu::LogWarning("Stream cancel was not taken, resetting decoder");
+    SoftwareReset();
+    ConfigureStream();
+  }
+
+  /// Sleeps until all data pushed into the feed ring has been sent.
+  void FlushFeedRing() const
+  {
+    while (feed_ring_ != nullptr && feed_ring_->GetSize() > 0)
+    {
+      KickFeeder();
+      WaitForDreq(kDreqTimeout);
+    }
+  }
+
+  /// Drains the feed ring from task context. The DREQ interrupt skips
+  /// draining while a task owns the bus, so the two never run concurrently.
+  void KickFeeder() const
+  {
+    if (feed_ring_ == nullptr)
+    {
+      return;
+    }
+    bus_.Acquire(SdiConfiguration(), SpiBus::Priority::kHigh);
+    {
+      DrainFeedRing(true);
+    }
+    bus_.Release();
+  }
+
+  /// Sends 32 byte chunks from the feed ring for as long as DREQ is high. The
+  /// caller must own the bus.
+  ///
+  /// @param use_dma False when called from an interrupt.
+  /// @param max_length Maximum number of bytes to send.
+  void DrainFeedRing(bool use_dma, size_t max_length = SIZE_MAX) const
+  {
+    uint8_t chunk[kSdiChunkSize];
+    for (size_t sent = 0; sent < max_length && pins_.dreq.Read() &&
+                          feed_ring_->GetSize() > 0;)
+    {
+      const size_t kLength =
+          feed_ring_->Pop(chunk, std::min(sizeof(chunk), max_length - sent));
+      TransmitSdi(chunk, kLength, use_dma);
+      sent += kLength;
+    }
+  }
+
+  void HandleDreqInterrupt() const
+  {
+    BaseType_t higher_priority_task_woken = pdFALSE;
+
+    // If a task owns the bus, it will kick the feeder once it is done.
+    if (feed_ring_ != nullptr && bus_.IsAvailableFromIsr())
+    {
+      DrainFeedRing(false, kMaxIsrFeedLength);
+      xSemaphoreGiveFromISR(space_semaphore_, &higher_priority_task_woken);
+    }
+    if (dreq_semaphore_ != nullptr)
+    {
+      xSemaphoreGiveFromISR(dreq_semaphore_, &higher_priority_task_woken);
+    }
+
+    portYIELD_FROM_ISR(higher_priority_task_woken);
+  }
+
+  const SpiBus & bus_;
   const ControlPins_t pins_;
   mutable units::frequency::hertz_t read_speed_  = 0_MHz;
   mutable units::frequency::hertz_t write_speed_ = 0_MHz;
+  mutable size_t sdi_bytes_                      = 0;
+
+  mutable StaticSemaphore_t dreq_semaphore_buffer_;
+  mutable StaticSemaphore_t space_semaphore_buffer_;
+  StaticSemaphore_t resume_semaphore_buffer_;
+  mutable SemaphoreHandle_t dreq_semaphore_  = nullptr;
+  mutable SemaphoreHandle_t space_semaphore_ = nullptr;
+  mutable SpscRing<uint8_t> * feed_ring_     = nullptr;
+  /// Given by Resume() to wake the task paused in Buffer().
+  SemaphoreHandle_t resume_semaphore_ = nullptr;
+  mutable std::atomic<bool> is_paused_ = false;
+
+  mutable Telemetry_t telemetry_;
+  mutable std::chrono::microseconds last_sdi_time_ = 0us;
 };
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "framebuffer.hpp"
+#include "graphics.hpp"
+
+namespace graphics
+{
+/// The drawing operations the code in graphics/ needs from a display, so it
+/// does not depend on a particular driver.
+class Display
+{
+ public:
+  /// Produces the pixels drawn by DrawColumns().
+  class ColumnSource
+  {
+   public:
+    /// @returns The pixel at (x, y) of the frame being drawn.
+    virtual Rgb565_t GetPixel(uint16_t x, uint16_t y) = 0;
+  };
+
+  virtual size_t GetWidth()  = 0;
+  virtual size_t GetHeight() = 0;
+
+  /// @returns The framebuffer that drawing goes to until the next Update(),
+  ///          or nullptr if drawing goes straight to the display.
+  virtual Framebuffer * GetFramebuffer() = 0;
+
+  /// Draws pixels straight to the display, bypassing any framebuffer.
+  ///
+  /// @param frame The frame to draw into.
+  /// @param source Called exactly once per pixel, column by column from the
+  ///               left, top to bottom within each column.
+  virtual void DrawColumns(Frame_t frame, ColumnSource & source) = 0;
+};
+}  // namespace graphics
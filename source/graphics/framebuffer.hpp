@@ -0,0 +1,322 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "graphics.hpp"
+
+namespace graphics
+{
+/// An in-RAM copy of a display's contents that tracks which regions changed
+/// since the last flush.
+///
+/// A full 128x160 buffer at 3 bytes per pixel would not fit in the LPC17xx's
+/// RAM, so pixels are stored as 4-bit indices into a 16 color palette, which is
+/// plenty for a UI and only takes 10 KB.
+class Framebuffer
+{
+ public:
+  /// Number of colors that can be displayed at once.
+  static constexpr size_t kPaletteSize = 16;
+  /// Maximum number of separate dirty regions that are tracked. When more
+  /// regions are marked, the pair that grows the least when combined is
+  /// merged.
+  static constexpr size_t kMaxDirtyFrames = 8;
+
+  size_t GetWidth() const
+  {
+    return width_;
+  }
+
+  size_t GetHeight() const
+  {
+    return height_;
+  }
+
+  /// Sets a pixel and marks it dirty if its color changed. Out of bounds
+  /// coordinates are ignored.
+  void SetPixel(int32_t x, int32_t y, Color_t color)
+  {
+    if (x < 0 || y < 0 || static_cast<size_t>(x) >= width_ ||
+        static_cast<size_t>(y) >= height_)
+    {
+      return;
+    }
+
+    const uint8_t kIndex = FindColor(color);
+    if (GetIndex(x, y) != kIndex)
+    {
+      SetIndex(x, y, kIndex);
+      MarkDirty(Rect_t{ x, y, x, y });
+    }
+  }
+
+  /// @returns The color of a pixel.
+  Color_t GetPixel(size_t x, size_t y) const
+  {
+    return palette_[GetIndex(x, y)];
+  }
+
+  /// Fills a frame with a color and marks it dirty.
+  void Fill(Frame_t frame, Color_t color)
+  {
+    const Rect_t kRect = Clip(frame);
+    if (kRect.IsEmpty())
+    {
+      return;
+    }
+
+    const uint8_t kIndex = FindColor(color);
+    for (int32_t y = kRect.top; y <= kRect.bottom; y++)
+    {
+      for (int32_t x = kRect.left; x <= kRect.right; x++)
+      {
+        SetIndex(x, y, kIndex);
+      }
+    }
+    MarkDirty(kRect);
+  }
+
+  /// Sets the pixels of a frame to colors generated on the fly and marks the
+  /// frame dirty. Pixels outside the buffer are skipped.
+  ///
+  /// @param frame The frame to draw into.
+  /// @param pixel_at Returns the color at (x, y) of the frame. Called column
+  ///                 by column from the left, top to bottom within each
+  ///                 column, the order displays are drawn in.
+  template <typename PixelSource>
+  void DrawPixels(Frame_t frame, PixelSource pixel_at)
+  {
+    const Rect_t kRect = Clip(frame);
+    if (kRect.IsEmpty())
+    {
+      return;
+    }
+
+    for (int32_t x = kRect.left; x <= kRect.right; x++)
+    {
+      for (int32_t y = kRect.top; y <= kRect.bottom; y++)
+      {
+        const Color_t kColor = pixel_at(static_cast<uint16_t>(x - kRect.left),
+                                        static_cast<uint16_t>(y - kRect.top));
+        SetIndex(x, y, FindColor(kColor));
+      }
+    }
+    MarkDirty(kRect);
+  }
+
+  /// Sets every pixel to a color without marking anything dirty. Used when the
+  /// display itself has already been filled with the same color.
+  void Reset(Color_t color)
+  {
+    palette_count_ = 0;
+    dirty_count_   = 0;
+
+    const uint8_t kIndex = FindColor(color);
+    std::fill(storage_,
+              storage_ + GetStorageSize(width_, height_),
+              static_cast<uint8_t>((kIndex << 4) | kIndex));
+  }
+
+  /// @returns True if any region changed since the last call to
+  ///          ClearDirty().
+  bool IsDirty() const
+  {
+    return dirty_count_ > 0;
+  }
+
+  /// @returns The number of dirty frames.
+  size_t GetDirtyCount() const
+  {
+    return dirty_count_;
+  }
+
+  /// @returns The dirty frame at the specified index.
+  Frame_t GetDirtyFrame(size_t index) const
+  {
+    const Rect_t & rect = dirty_[index];
+    return Frame_t(static_cast<uint16_t>(rect.left),
+                   static_cast<uint16_t>(rect.top),
+                   rect.right - rect.left + 1,
+                   rect.bottom - rect.top + 1);
+  }
+
+  /// Marks all regions as clean.
+  void ClearDirty()
+  {
+    dirty_count_ = 0;
+  }
+
+  /// @returns The number of bytes required to store a buffer of the specified
+  ///          dimensions.
+  static constexpr size_t GetStorageSize(size_t width, size_t height)
+  {
+    return (width * height + 1) / 2;
+  }
+
+ protected:
+  /// @param storage Backing storage of at least GetStorageSize() bytes.
+  Framebuffer(uint8_t * storage, size_t width, size_t height)
+      : storage_(storage), width_(width), height_(height)
+  {
+  }
+
+ private:
+  /// Inclusive pixel bounds of a region.
+  struct Rect_t
+  {
+    int32_t left;
+    int32_t top;
+    int32_t right;
+    int32_t bottom;
+
+    bool IsEmpty() const
+    {
+      return right < left || bottom < top;
+    }
+
+    int32_t GetArea() const
+    {
+      return (right - left + 1) * (bottom - top + 1);
+    }
+
+    Rect_t Union(const Rect_t & other) const
+    {
+      return Rect_t{ std::min(left, other.left),
+                     std::min(top, other.top),
+                     std::max(right, other.right),
+                     std::max(bottom, other.bottom) };
+    }
+
+    /// @returns True if the regions overlap or share an edge.
+    bool Touches(const Rect_t & other) const
+    {
+      return left <= other.right + 1 && other.left <= right + 1 &&
+             top <= other.bottom + 1 && other.top <= bottom + 1;
+    }
+  };
+
+  Rect_t Clip(Frame_t frame) const
+  {
+    return Rect_t{
+      frame.origin.x,
+      frame.origin.y,
+      std::min<int32_t>(frame.origin.x + frame.size.width, width_) - 1,
+      std::min<int32_t>(frame.origin.y + frame.size.height, height_) - 1,
+    };
+  }
+
+  void MarkDirty(Rect_t rect)
+  {
+    // Absorb any regions that touch the new one, repeating since the grown
+    // region may now touch regions it did not before.
+    for (size_t i = 0; i < dirty_count_;)
+    {
+      if (rect.Touches(dirty_[i]))
+      {
+        rect      = rect.Union(dirty_[i]);
+        dirty_[i] = dirty_[--dirty_count_];
+        i         = 0;
+      }
+      else
+      {
+        i++;
+      }
+    }
+
+    if (dirty_count_ < kMaxDirtyFrames)
+    {
+      dirty_[dirty_count_++] = rect;
+      return;
+    }
+
+    // Out of slots, merge with the region that grows the least.
+    size_t best_index   = 0;
+    int32_t best_growth = INT32_MAX;
+    for (size_t i = 0; i < dirty_count_; i++)
+    {
+      const int32_t kGrowth = rect.Union(dirty_[i]).GetArea() -
+                              dirty_[i].GetArea() - rect.GetArea();
+      if (kGrowth < best_growth)
+      {
+        best_growth = kGrowth;
+        best_index  = i;
+      }
+    }
+    dirty_[best_index] = rect.Union(dirty_[best_index]);
+  }
+
+  /// @returns The palette index of a color, adding it to the palette if there
+  ///          is room or using the closest existing color otherwise.
+  uint8_t FindColor(Color_t color)
+  {
+    size_t closest_index      = 0;
+    uint32_t closest_distance = UINT32_MAX;
+    for (size_t i = 0; i < palette_count_; i++)
+    {
+      const int32_t kRed       = palette_[i].red - color.red;
+      const int32_t kGreen     = palette_[i].green - color.green;
+      const int32_t kBlue      = palette_[i].blue - color.blue;
+      const uint32_t kDistance = static_cast<uint32_t>(
+          kRed * kRed + kGreen * kGreen + kBlue * kBlue);
+      if (kDistance == 0)
+      {
+        return static_cast<uint8_t>(i);
+      }
+      if (kDistance < closest_distance)
+      {
+        closest_distance = kDistance;
+        closest_index    = i;
+      }
+    }
+
+    if (palette_count_ < kPaletteSize)
+    {
+      palette_[palette_count_] = color;
+      return static_cast<uint8_t>(palette_count_++);
+    }
+    return static_cast<uint8_t>(closest_index);
+  }
+
+  uint8_t GetIndex(size_t x, size_t y) const
+  {
+    const size_t kPixel = y * width_ + x;
+    const uint8_t kByte = storage_[kPixel / 2];
+    return (kPixel & 1) ? (kByte & 0x0F) : (kByte >> 4);
+  }
+
+  void SetIndex(size_t x, size_t y, uint8_t index)
+  {
+    const size_t kPixel = y * width_ + x;
+    uint8_t & byte      = storage_[kPixel / 2];
+    byte = (kPixel & 1) ? static_cast<uint8_t>((byte & 0xF0) | index)
+                        : static_cast<uint8_t>((byte & 0x0F) | (index << 4));
+  }
+
+  uint8_t * const storage_;
+  const size_t width_;
+  const size_t height_;
+
+  std::array<Color_t, kPaletteSize> palette_ = {};
+  size_t palette_count_                      = 0;
+
+  std::array<Rect_t, kMaxDirtyFrames> dirty_ = {};
+  size_t dirty_count_                        = 0;
+};
+
+/// A Framebuffer backed by statically allocated storage.
+///
+/// @tparam kWidth Width of the display in pixels.
+/// @tparam kHeight Height of the display in pixels.
+template <size_t kWidth, size_t kHeight>
+class StaticFramebuffer final : public Framebuffer
+{
+ public:
+  StaticFramebuffer() : Framebuffer(storage_, kWidth, kHeight) {}
+
+ private:
+  uint8_t storage_[GetStorageSize(kWidth, kHeight)] = {};
+};
+}  // namespace graphics
@@ -11,6 +11,30 @@ struct Color_t
   uint8_t blue;
 };
 
+/// A color packed into 16 bits as 5 bits of red, 6 bits of green and 5 bits
+/// of blue, the native format of displays running in 16-bit pixel mode.
+struct Rgb565_t
+{
+  uint16_t value;
+
+  constexpr Rgb565_t(uint16_t packed_value = 0) : value(packed_value) {}
+
+  explicit constexpr Rgb565_t(Color_t color)
+      : value(static_cast<uint16_t>(((color.red & 0xF8) << 8) |
+                                    ((color.green & 0xFC) << 3) |
+                                    (color.blue >> 3)))
+  {
+  }
+
+  /// @returns The color with the dropped low bits of each channel set to 0.
+  constexpr Color_t ToColor() const
+  {
+    return Color_t{ .red   = static_cast<uint8_t>((value >> 8) & 0xF8),
+                    .green = static_cast<uint8_t>((value >> 3) & 0xFC),
+                    .blue  = static_cast<uint8_t>((value << 3) & 0xF8) };
+  }
+};
+
 static constexpr Color_t kWhite =
     Color_t{ .red = 0xFF, .green = 0xFF, .blue = 0xFF };
 static constexpr Color_t kBlack =
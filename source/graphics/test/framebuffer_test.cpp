@@ -0,0 +1,155 @@
+#include "L4_Testing/testing_frameworks.hpp"
+
+#include "../framebuffer.hpp"
+
+namespace
+{
+constexpr size_t kScreenWidth  = 32;
+constexpr size_t kScreenHeight = 16;
+
+graphics::Color_t Gray(uint8_t level)
+{
+  return graphics::Color_t{ .red = level, .green = level, .blue = level };
+}
+
+bool IsSameColor(graphics::Color_t a, graphics::Color_t b)
+{
+  return a.red == b.red && a.green == b.green && a.blue == b.blue;
+}
+
+bool IsFrame(graphics::Frame_t frame,
+             uint16_t x,
+             uint16_t y,
+             size_t width,
+             size_t height)
+{
+  return frame.origin.x == x && frame.origin.y == y &&
+         frame.size.width == width && frame.size.height == height;
+}
+}  // namespace
+
+TEST_CASE("Testing Framebuffer")
+{
+  graphics::StaticFramebuffer<kScreenWidth, kScreenHeight> framebuffer;
+  framebuffer.Reset(graphics::kWhite);
+
+  SECTION("Reset() fills the buffer without marking it dirty")
+  {
+    CHECK_FALSE(framebuffer.IsDirty());
+    CHECK(IsSameColor(framebuffer.GetPixel(31, 15), graphics::kWhite));
+  }
+
+  SECTION("Setting a pixel to its own color marks nothing dirty")
+  {
+    framebuffer.SetPixel(3, 4, graphics::kWhite);
+
+    CHECK_FALSE(framebuffer.IsDirty());
+  }
+
+  SECTION("Out of bounds pixels are ignored")
+  {
+    framebuffer.SetPixel(-1, 0, graphics::kBlack);
+    framebuffer.SetPixel(0, kScreenHeight, graphics::kBlack);
+
+    CHECK_FALSE(framebuffer.IsDirty());
+  }
+
+  SECTION("Pixels that touch are merged into one region")
+  {
+    framebuffer.SetPixel(3, 4, graphics::kBlack);
+    framebuffer.SetPixel(4, 4, graphics::kBlack);
+    framebuffer.SetPixel(4, 5, graphics::kBlack);
+
+    REQUIRE(framebuffer.GetDirtyCount() == 1);
+    CHECK(IsFrame(framebuffer.GetDirtyFrame(0), 3, 4, 2, 2));
+    CHECK(IsSameColor(framebuffer.GetPixel(4, 5), graphics::kBlack));
+  }
+
+  SECTION("A region that grows into others absorbs them")
+  {
+    framebuffer.SetPixel(0, 0, graphics::kBlack);
+    framebuffer.SetPixel(4, 0, graphics::kBlack);
+    CHECK(framebuffer.GetDirtyCount() == 2);
+
+    // Touches the first region, and once merged with it, the second.
+    framebuffer.Fill(graphics::Frame_t(1, 0, 3, 1), graphics::kRed);
+
+    REQUIRE(framebuffer.GetDirtyCount() == 1);
+    CHECK(IsFrame(framebuffer.GetDirtyFrame(0), 0, 0, 5, 1));
+  }
+
+  SECTION("Past kMaxDirtyFrames, the region that grows least is merged")
+  {
+    constexpr size_t kMaxDirtyFrames = graphics::Framebuffer::kMaxDirtyFrames;
+    for (uint16_t i = 0; i < kMaxDirtyFrames; i++)
+    {
+      framebuffer.SetPixel(i * 4, 0, graphics::kBlack);
+    }
+    CHECK(framebuffer.GetDirtyCount() == kMaxDirtyFrames);
+
+    framebuffer.SetPixel(0, 10, graphics::kBlack);
+
+    CHECK(framebuffer.GetDirtyCount() == kMaxDirtyFrames);
+    bool is_merged = false;
+    for (size_t i = 0; i < framebuffer.GetDirtyCount(); i++)
+    {
+      is_merged = is_merged ||
+                  IsFrame(framebuffer.GetDirtyFrame(i), 0, 0, 1, 11);
+    }
+    CHECK(is_merged);
+  }
+
+  SECTION("Fill() clips to the screen and ClearDirty() clears regions")
+  {
+    framebuffer.Fill(graphics::Frame_t(30, 14, 10, 10), graphics::kBlue);
+
+    REQUIRE(framebuffer.GetDirtyCount() == 1);
+    CHECK(IsFrame(framebuffer.GetDirtyFrame(0), 30, 14, 2, 2));
+
+    framebuffer.ClearDirty();
+
+    CHECK_FALSE(framebuffer.IsDirty());
+    CHECK(IsSameColor(framebuffer.GetPixel(31, 15), graphics::kBlue));
+  }
+
+  SECTION("DrawPixels() draws the frame column by column and marks it dirty")
+  {
+    // Clipped to the 2 columns left of the screen.
+    size_t next_x    = 0;
+    size_t next_y    = 0;
+    bool is_in_order = true;
+    const auto kColorAt = [&](uint16_t x, uint16_t y) {
+      is_in_order = is_in_order && x == next_x && y == next_y;
+      next_y      = (y + 1) % 3;
+      next_x      = (next_y == 0) ? x + 1 : x;
+      return (x == y) ? graphics::kBlack : graphics::kWhite;
+    };
+    framebuffer.DrawPixels(graphics::Frame_t(30, 2, 4, 3), kColorAt);
+
+    CHECK(is_in_order);
+    CHECK(next_x == 2);
+    REQUIRE(framebuffer.GetDirtyCount() == 1);
+    CHECK(IsFrame(framebuffer.GetDirtyFrame(0), 30, 2, 2, 3));
+    CHECK(IsSameColor(framebuffer.GetPixel(31, 3), graphics::kBlack));
+    CHECK(IsSameColor(framebuffer.GetPixel(31, 2), graphics::kWhite));
+  }
+
+  SECTION("Colors past the palette's size use the closest color")
+  {
+    // White is the first of the palette's colors.
+    for (uint8_t i = 0; i < graphics::Framebuffer::kPaletteSize - 1; i++)
+    {
+      framebuffer.SetPixel(i, 0, Gray(static_cast<uint8_t>(i * 16)));
+    }
+    framebuffer.SetPixel(0, 1, Gray(19));
+    framebuffer.SetPixel(1, 1, Gray(250));
+
+    for (uint8_t i = 0; i < graphics::Framebuffer::kPaletteSize - 1; i++)
+    {
+      CHECK(IsSameColor(framebuffer.GetPixel(i, 0),
+                        Gray(static_cast<uint8_t>(i * 16))));
+    }
+    CHECK(IsSameColor(framebuffer.GetPixel(0, 1), Gray(16)));
+    CHECK(IsSameColor(framebuffer.GetPixel(1, 1), graphics::kWhite));
+  }
+}
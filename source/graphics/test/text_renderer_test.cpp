@@ -0,0 +1,129 @@
+#include <string_view>
+
+#include "L4_Testing/testing_frameworks.hpp"
+
+#include "../../../simulation/source/fake_gpio.hpp"
+#include "../../../simulation/source/fake_spi.hpp"
+#include "../../../simulation/source/st7735_model.hpp"
+#include "../../drivers/spi_bus.hpp"
+#include "../../drivers/st7735.hpp"
+#include "../fonts.hpp"
+#include "../framebuffer.hpp"
+#include "../text_renderer.hpp"
+
+namespace
+{
+constexpr size_t kScreenWidth  = 40;
+constexpr size_t kScreenHeight = 20;
+}  // namespace
+
+TEST_CASE("Testing TextRenderer")
+{
+  FakeSpi spi;
+  FakeGpio rst;
+  FakeGpio cs;
+  FakeGpio dc;
+  cs.SetHigh();
+  dc.SetHigh();
+  SpiBus bus(spi);
+  St7735 display(bus, 1_MHz, rst, cs, dc, kScreenWidth, kScreenHeight);
+  St7735Model<kScreenHeight, kScreenWidth> model({ .cs = cs, .dc = dc });
+  spi.Attach(model);
+  display.SetPixelFormat(St7735::PixelFormat::kRgb565);
+  graphics::TextRenderer renderer(display);
+
+  const graphics::Rgb565_t kForeground(graphics::kBlack);
+  const graphics::Rgb565_t kBackground(graphics::kWhite);
+  const graphics::TextRenderer::Style_t kStyle = {
+    .foreground = graphics::kBlack,
+    .background = graphics::kWhite,
+    .scale      = 2,
+  };
+
+  // Renders the expected pixel of a glyph cell directly from the font, row
+  // by row.
+  const auto kExpectedAt = [&](std::string_view text, size_t x, size_t y) {
+    const size_t kColumn = x / kStyle.scale;
+    const size_t kRow    = y / kStyle.scale;
+    const size_t kIndex  = kColumn / graphics::TextRenderer::kCellWidth;
+    const size_t kGlyphColumn = kColumn % graphics::TextRenderer::kCellWidth;
+    if (kGlyphColumn >= 5)
+    {
+      return kBackground.value;
+    }
+    const uint8_t kBits =
+        graphics::fonts::font[static_cast<uint8_t>(text[kIndex])][kGlyphColumn];
+    return ((kBits >> kRow) & 1) ? kForeground.value : kBackground.value;
+  };
+
+  SECTION("DrawText() draws scaled glyphs taller than one row in place")
+  {
+    constexpr std::string_view kText = "A7";
+    const graphics::Frame_t kFrame =
+        renderer.DrawText({ .x = 3, .y = 2 }, kText, kStyle);
+
+    CHECK(kFrame.size.width == 2 * 6 * 2);
+    CHECK(kFrame.size.height == 8 * 2);
+    CHECK(model.GetPixelCount() == kFrame.size.width * kFrame.size.height);
+    for (size_t y = 0; y < kFrame.size.height; y++)
+    {
+      for (size_t x = 0; x < kFrame.size.width; x++)
+      {
+        CHECK(model.GetPixel(2 + y, 3 + x) == kExpectedAt(kText, x, y));
+      }
+    }
+  }
+
+  SECTION("DrawText() cuts off text at the edge of the display")
+  {
+    constexpr std::string_view kText = "ABCD";
+    const graphics::Frame_t kFrame =
+        renderer.DrawText({ .x = 20, .y = 10 }, kText, kStyle);
+
+    CHECK(kFrame.size.width == kScreenWidth - 20);
+    CHECK(kFrame.size.height == kScreenHeight - 10);
+    for (size_t y = 0; y < kFrame.size.height; y++)
+    {
+      for (size_t x = 0; x < kFrame.size.width; x++)
+      {
+        CHECK(model.GetPixel(10 + y, 20 + x) == kExpectedAt(kText, x, y));
+      }
+    }
+  }
+
+  SECTION("DrawText() draws into the framebuffer until Update()")
+  {
+    graphics::StaticFramebuffer<kScreenWidth, kScreenHeight> framebuffer;
+    St7735 buffered_display(
+        bus, 1_MHz, rst, cs, dc, kScreenWidth, kScreenHeight, &framebuffer);
+    buffered_display.SetPixelFormat(St7735::PixelFormat::kRgb565);
+    framebuffer.Reset(graphics::kWhite);
+    graphics::TextRenderer buffered_renderer(buffered_display);
+    const size_t kStartCount = model.GetPixelCount();
+
+    constexpr std::string_view kText = "A7";
+    const graphics::Frame_t kFrame =
+        buffered_renderer.DrawText({ .x = 3, .y = 2 }, kText, kStyle);
+
+    CHECK(model.GetPixelCount() == kStartCount);
+    for (size_t y = 0; y < kFrame.size.height; y++)
+    {
+      for (size_t x = 0; x < kFrame.size.width; x++)
+      {
+        CHECK(graphics::Rgb565_t(framebuffer.GetPixel(3 + x, 2 + y)).value ==
+              kExpectedAt(kText, x, y));
+      }
+    }
+
+    buffered_display.Update();
+
+    CHECK_FALSE(framebuffer.IsDirty());
+    for (size_t y = 0; y < kFrame.size.height; y++)
+    {
+      for (size_t x = 0; x < kFrame.size.width; x++)
+      {
+        CHECK(model.GetPixel(2 + y, 3 + x) == kExpectedAt(kText, x, y));
+      }
+    }
+  }
+}
@@ -0,0 +1,238 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "display.hpp"
+#include "fonts.hpp"
+#include "graphics.hpp"
+
+namespace graphics
+{
+/// Renders text with the 5x7 font in fonts.hpp.
+///
+/// Each call to DrawText() draws the whole string as a single frame. Displays
+/// consume pixels column by column, which is also how the font stores its
+/// glyphs, so each column of the glyphs is looked up once as the display
+/// reaches it. No per-glyph or per-pixel windows are needed and the string is
+/// never stored as a full bitmap.
+///
+/// Text goes into the display's framebuffer when it has one, and reaches the
+/// display with the rest of the framebuffer on the next Update(). Otherwise it
+/// is sent straight to the display through a single address window.
+class TextRenderer
+{
+ public:
+  /// Width of a glyph's cell in unscaled pixels, including 1 pixel of spacing.
+  static constexpr size_t kCellWidth = 6;
+  /// Height of a glyph's cell in unscaled pixels, the 8th row is blank.
+  static constexpr size_t kCellHeight = 8;
+  /// Maximum width of a text run in pixels.
+  static constexpr size_t kMaxLineWidth = 160;
+
+  struct Style_t
+  {
+    Color_t foreground = kBlack;
+    Color_t background = kWhite;
+    /// Integer scale factor applied to each glyph.
+    uint8_t scale = 1;
+  };
+
+  explicit TextRenderer(Display & display) : display_(display) {}
+
+  /// @returns The size of the area covered when drawing text.
+  static Size_t Measure(std::string_view text, const Style_t & style)
+  {
+    return Size_t{ .width  = text.size() * kCellWidth * style.scale,
+                   .height = kCellHeight * style.scale };
+  }
+
+  /// Draws a single run of text. Text that does not fit within the display or
+  /// kMaxLineWidth is cut off.
+  ///
+  /// @param origin Top left corner of the text.
+  /// @param text The text to draw.
+  /// @param style The colors and scale of the text.
+  /// @returns The frame that was drawn, with a width of 0 if nothing was.
+  Frame_t DrawText(Point_t origin,
+                   std::string_view text,
+                   const Style_t & style)
+  {
+    const Size_t kSize          = Measure(text, style);
+    const size_t kDisplayWidth  = display_.GetWidth();
+    const size_t kDisplayHeight = display_.GetHeight();
+    const size_t kAvailableWidth =
+        std::min(kDisplayWidth - std::min<size_t>(origin.x, kDisplayWidth),
+                 kMaxLineWidth);
+    const size_t kAvailableHeight =
+        kDisplayHeight - std::min<size_t>(origin.y, kDisplayHeight);
+
+    const Frame_t kFrame(origin.x,
+                         origin.y,
+                         std::min(kSize.width, kAvailableWidth),
+                         std::min(kSize.height, kAvailableHeight));
+    if (kFrame.size.width == 0 || kFrame.size.height == 0)
+    {
+      return Frame_t(origin.x, origin.y, 0, 0);
+    }
+
+    GlyphSource glyphs(text, style);
+    if (Framebuffer * framebuffer = display_.GetFramebuffer())
+    {
+      const auto kColorAt = [&glyphs, &style](uint16_t x, uint16_t y) {
+        return glyphs.IsForeground(x, y) ? style.foreground : style.background;
+      };
+      framebuffer->DrawPixels(kFrame, kColorAt);
+    }
+    else
+    {
+      display_.DrawColumns(kFrame, glyphs);
+    }
+
+    return kFrame;
+  }
+
+ private:
+  /// Produces the pixels of a run of text, keeping the column of the glyphs
+  /// being drawn.
+  class GlyphSource final : public Display::ColumnSource
+  {
+   public:
+    GlyphSource(std::string_view text, const Style_t & style)
+        : text_(text),
+          scale_(style.scale),
+          foreground_(style.foreground),
+          background_(style.background)
+    {
+    }
+
+    /// @returns True if the pixel at (x, y) of the text is in a glyph.
+    bool IsForeground(uint16_t x, uint16_t y)
+    {
+      const size_t kColumn = x / scale_;
+      if (kColumn != buffered_column_)
+      {
+        column_bits_     = GetColumnBits(text_, kColumn);
+        buffered_column_ = kColumn;
+      }
+      const size_t kRow = y / scale_;
+      return (column_bits_ >> kRow) & 1;
+    }
+
+    Rgb565_t GetPixel(uint16_t x, uint16_t y) override
+    {
+      return IsForeground(x, y) ? foreground_ : background_;
+    }
+
+   private:
+    const std::string_view text_;
+    const uint8_t scale_;
+    const Rgb565_t foreground_;
+    const Rgb565_t background_;
+    size_t buffered_column_ = SIZE_MAX;
+    uint8_t column_bits_    = 0;
+  };
+
+  /// @param text The text being drawn.
+  /// @param column An unscaled column of the text.
+  /// @returns The pixels of the column, bit n set for a foreground pixel in
+  ///          row n.
+  static uint8_t GetColumnBits(std::string_view text, size_t column)
+  {
+    const size_t kCharacter   = column / kCellWidth;
+    const size_t kGlyphColumn = column % kCellWidth;
+    if (kCharacter >= text.size() || kGlyphColumn >= std::size(fonts::font[0]))
+    {
+      return 0;
+    }
+    const uint8_t * glyph = fonts::font[std::min<uint8_t>(
+        static_cast<uint8_t>(text[kCharacter]), std::size(fonts::font) - 1)];
+    return glyph[kGlyphColumn];
+  }
+
+  Display & display_;
+};
+
+/// A fixed length run of text at a fixed position, such as a clock or a track
+/// title, that is updated in place.
+///
+/// SetText() only redraws the span of characters that differ from what is on
+/// screen, so an elapsed time ticking from 1:08 to 1:09 sends one glyph to the
+/// display rather than the whole field.
+///
+/// @tparam kLength Number of characters in the field. Shorter text is padded
+///                 with spaces and longer text is cut off.
+template <size_t kLength>
+class TextField
+{
+ public:
+  TextField(TextRenderer & renderer,
+            Point_t origin,
+            const TextRenderer::Style_t & style)
+      : renderer_(renderer), origin_(origin), style_(style)
+  {
+  }
+
+  /// Updates the field, redrawing only the characters that changed.
+  void SetText(std::string_view text)
+  {
+    std::array<char, kLength> next;
+    next.fill(' ');
+    std::copy_n(text.begin(), std::min(text.size(), kLength), next.begin());
+
+    size_t first = 0;
+    size_t last  = kLength;
+    if (is_drawn_)
+    {
+      while (first < kLength && next[first] == text_[first])
+      {
+        first++;
+      }
+      if (first == kLength)
+      {
+        return;
+      }
+      while (next[last - 1] == text_[last - 1])
+      {
+        last--;
+      }
+    }
+
+    text_     = next;
+    is_drawn_ = true;
+
+    const size_t kCellWidth = TextRenderer::kCellWidth * style_.scale;
+    renderer_.DrawText(
+        Point_t{ .x = static_cast<uint16_t>(origin_.x + first * kCellWidth),
+                 .y = origin_.y },
+        std::string_view(text_.data() + first, last - first),
+        style_);
+  }
+
+  /// Forces the next SetText() to redraw the whole field, for example after
+  /// the display was cleared.
+  void Invalidate()
+  {
+    is_drawn_ = false;
+  }
+
+  /// @returns The frame covered by the field.
+  Frame_t GetFrame() const
+  {
+    return Frame_t(origin_.x,
+                   origin_.y,
+                   kLength * TextRenderer::kCellWidth * style_.scale,
+                   TextRenderer::kCellHeight * style_.scale);
+  }
+
+ private:
+  TextRenderer & renderer_;
+  const Point_t origin_;
+  const TextRenderer::Style_t style_;
+  std::array<char, kLength> text_;
+  bool is_drawn_ = false;
+};
+}  // namespace graphics
@@ -1,3 +1,5 @@
+#include <type_traits>
+
 #include "L0_Platform/startup.hpp"
 #include "L1_Peripheral/lpc17xx/gpio.hpp"
 #include "L1_Peripheral/lpc17xx/spi.hpp"
@@ -5,10 +7,20 @@
 #include "L3_Application/fatfs.hpp"
 #include "utility/log.hpp"
 
+#include "drivers/lpc17xx_ssp_dma.hpp"
+#include "drivers/spi_bus.hpp"
 #include "drivers/st7735.hpp"
 #include "drivers/vs1053b.hpp"
+#include "graphics/framebuffer.hpp"
 #include "tasks/audio_data_buffer_task.hpp"
+#include "tasks/display_benchmark_task.hpp"
 #include "tasks/mp3_player_task.hpp"
+#include "tasks/playback_benchmark_task.hpp"
+#include "tasks/seek_index_task.hpp"
+#include "tasks/telemetry_task.hpp"
+#include "utility/memory_budget.hpp"
+#include "utility/pipeline_config.hpp"
+#include "utility/spsc_ring.hpp"
 
 // private namespace
 namespace
@@ -24,31 +36,46 @@ sjsu::lpc17xx::Gpio dreq(2, 4);  // blue
 sjsu::lpc17xx::Gpio rst(2, 5);   // gree
 sjsu::lpc17xx::Gpio cs(2, 6);    // yellow
 sjsu::lpc17xx::Gpio dcs(2, 7);   // orange
-Vs1053b mp3_decoder(spi0,
+Lpc17xxSspDma spi0_dma(sjsu::lpc17xx::LPC_SSP0,
+                       Lpc17xxSspDma::Request::kSsp0Transmit,
+                       0);
+SpiBus spi0_bus(spi0, &spi0_dma);
+Vs1053b mp3_decoder(spi0_bus,
                     {
                         .rst  = rst,
                         .cs   = cs,
                         .dcs  = dcs,
                         .dreq = dreq,
                     });
+/// When true, audio data is fed to the decoder from the DREQ interrupt
+/// instead of from AudioDataDecodeTask.
+constexpr bool kFeedDecoderFromIsr = false;
+/// Audio data queued for the DREQ interrupt. Shrunk to a single byte when the
+/// decoder is fed by AudioDataDecodeTask.
+constexpr size_t kSdiFeedRingSize = kFeedDecoderFromIsr ? 4 * 1024 : 1;
+StaticSpscRing<uint8_t, kSdiFeedRingSize> sdi_feed_ring;
 
 // -----------------------------------------------------------------------------
 //                                TFT LCD
 // -----------------------------------------------------------------------------
 
-// constexpr units::frequency::hertz_t kLcdFrequency = 12_MHz;
-// constexpr size_t kLcdScreenWidth                  = 128;
-// constexpr size_t kLcdScreenHeight                 = 160;
-// sjsu::lpc17xx::Gpio lcd_dc(0, 1);
-// sjsu::lpc17xx::Gpio lcd_rst(0, 0);
-// sjsu::lpc17xx::Gpio lcd_cs(2, 7);
-// St7735 lcd(spi0,
-//            kLcdFrequency,
-//            lcd_rst,
-//            lcd_cs,
-//            lcd_dc,
-//            kLcdScreenWidth,
-//            kLcdScreenHeight);
+// The LCD shares spi0 with the decoder, SpiBus arbitrates between the two and
+// gives the decoder priority.
+constexpr units::frequency::hertz_t kLcdFrequency = 12_MHz;
+constexpr size_t kLcdScreenWidth                  = 128;
+constexpr size_t kLcdScreenHeight                 = 160;
+sjsu::lpc17xx::Gpio lcd_dc(0, 1);
+sjsu::lpc17xx::Gpio lcd_rst(0, 0);
+sjsu::lpc17xx::Gpio lcd_cs(2, 8);
+graphics::StaticFramebuffer<kLcdScreenWidth, kLcdScreenHeight> lcd_framebuffer;
+St7735 lcd(spi0_bus,
+           kLcdFrequency,
+           lcd_rst,
+           lcd_cs,
+           lcd_dc,
+           kLcdScreenWidth,
+           kLcdScreenHeight,
+           &lcd_framebuffer);
 
 // -----------------------------------------------------------------------------
 //                                  SD Card
@@ -62,16 +89,121 @@ sjsu::Sd sd_card(spi1, sd_cs, sd_cd);
 //                                  Tasks
 // -----------------------------------------------------------------------------
 
+/// Block length and depth of the audio pipeline.
+using Pipeline = DefaultPipelineConfig;
+static_assert(Pipeline::kSdiBurstLength == Vs1053b::kSdiChunkSize);
+
+/// The payloads of the audio blocks, placed in the first AHB SRAM bank so
+/// that the GPDMA can send them to the decoder. Blocks in the local SRAM would
+/// be sent by the CPU. The memory budget checks that they fit.
+[[gnu::section(".bss.$RAM2")]] Pipeline::BlockStorage audio_block_storage;
+
 sjsu::rtos::TaskScheduler task_scheduler;
-Mp3PlayerTask mp3_player_task(mp3_decoder);
-AudioDataBufferTask<Mp3PlayerTask::kBufferLength> audio_buffer_task(
-    mp3_player_task);
-AudioDataDecodeTask<Mp3PlayerTask::kBufferLength> decoder_task(mp3_player_task);
+Mp3PlayerTask<Pipeline> mp3_player_task(mp3_decoder, audio_block_storage);
+AudioDataBufferTask<Pipeline> audio_buffer_task(mp3_player_task);
+AudioDataDecodeTask<Pipeline> decoder_task(mp3_player_task);
+SeekIndexTask seek_index_task(mp3_player_task.GetSeekIndex());
+
+/// Stands in for a task that is turned off, so that neither its stack nor
+/// its buffers take any RAM.
+struct DisabledTask
+{
+  template <typename... Args>
+  explicit DisabledTask(Args &&...)
+  {
+  }
+};
+
+/// A task that is only built when kEnabled is true.
+template <bool kEnabled, typename Task>
+using OptionalTask = std::conditional_t<kEnabled, Task, DisabledTask>;
+
+/// Sets up a task that is built. The setup of a DisabledTask is discarded
+/// without being compiled.
+///
+/// @param task The task.
+/// @param setup Called with the task.
+template <typename Task, typename Setup>
+void SetUpIfEnabled(Task & task, Setup setup)
+{
+  if constexpr (!std::is_same_v<Task, DisabledTask>)
+  {
+    setup(task);
+  }
+}
+
+/// When true, the display is continuously redrawn during playback to measure
+/// the impact of display traffic on the audio stream.
+constexpr bool kRunDisplayBenchmark = false;
+OptionalTask<kRunDisplayBenchmark, DisplayBenchmarkTask<Pipeline>>
+    display_benchmark_task(lcd, decoder_task);
+
+/// When true, the pipeline telemetry is logged periodically. The counters are
+/// always maintained by the pipeline's tasks and the decoder driver.
+constexpr bool kLogTelemetry = false;
+OptionalTask<kLogTelemetry, TelemetryTask<Pipeline>> telemetry_task(
+    mp3_decoder,
+    audio_buffer_task,
+    decoder_task);
+
+/// When true, the files listed in the benchmark corpus are played instead of
+/// the song list, and throughput and underrun results are printed as JSON.
+constexpr bool kRunPlaybackBenchmark = false;
+OptionalTask<kRunPlaybackBenchmark, PlaybackBenchmarkTask<Pipeline>>
+    playback_benchmark_task(mp3_player_task,
+                            mp3_decoder,
+                            audio_buffer_task,
+                            decoder_task);
+
+// -----------------------------------------------------------------------------
+//                               Memory Budget
+// -----------------------------------------------------------------------------
+
+/// SRAM banks of the LPC1769. Global objects are placed in the local SRAM
+/// unless they are given a section of an AHB bank.
+enum RamBank : size_t
+{
+  kLocalRam,
+  kAhbRam0,
+  kAhbRam1,
+};
+
+constexpr MemoryBudget<3, 8> kMemoryBudget(
+    { {
+        { "local", 32 * 1024 },
+        { "AHB 0", Lpc17xxSspDma::kAhbRamBankSize },
+        { "AHB 1", Lpc17xxSspDma::kAhbRamBankSize },
+    } },
+    { {
+        { "audio blocks", sizeof(audio_block_storage), kAhbRam0 },
+        { "player, library", sizeof(mp3_player_task), kLocalRam },
+        { "buffer task", sizeof(audio_buffer_task), kLocalRam },
+        { "decode task", sizeof(decoder_task), kLocalRam },
+        { "seek index task", sizeof(seek_index_task), kLocalRam },
+        { "decoder, spi0",
+          sizeof(mp3_decoder) + sizeof(sdi_feed_ring) + sizeof(spi0_bus) +
+              sizeof(spi0_dma),
+          kLocalRam },
+        { "display", sizeof(lcd) + sizeof(lcd_framebuffer), kLocalRam },
+        { "telemetry, benchmarks",
+          sizeof(telemetry_task) + sizeof(display_benchmark_task) +
+              sizeof(playback_benchmark_task),
+          kLocalRam },
+    } });
+static_assert(kMemoryBudget.IsWithinBudget(kLocalRam),
+              "The global objects do not fit in the local SRAM, shrink the "
+              "pipeline or move objects to an AHB bank.");
+static_assert(kMemoryBudget.IsWithinBudget(kAhbRam0),
+              "The audio blocks do not fit in the first AHB SRAM bank, "
+              "shrink the pipeline.");
+static_assert(kMemoryBudget.IsWithinBudget(kAhbRam1),
+              "The objects of the second AHB SRAM bank do not fit.");
 }  // namespace
 
 int main()
 {
   sjsu::LogDebug("Starting Application");
+  kMemoryBudget.Log();
 
   /// Configures the CPU clock to run at 96 MHz.
   auto & system_controller   = sjsu::SystemController::GetPlatformController();
@@ -96,10 +228,36 @@ int main()
 
   mp3_decoder.Initialize();
   mp3_decoder.SetVolume(0.8f);
+  if constexpr (kFeedDecoderFromIsr)
+  {
+    mp3_decoder.EnableIsrFeeding(sdi_feed_ring);
+  }
+  else
+  {
+    mp3_decoder.EnableDreqInterrupt();
+  }
+
+  lcd.Initialize();
 
+  SetUpIfEnabled(playback_benchmark_task, [](auto & task) {
+    // The player only carries out the benchmark's commands.
+    mp3_player_task.SetAutoPlay(false);
+    task_scheduler.AddTask(&task);
+  });
   task_scheduler.AddTask(&mp3_player_task);
   task_scheduler.AddTask(&audio_buffer_task);
   task_scheduler.AddTask(&decoder_task);
+  task_scheduler.AddTask(&seek_index_task);
+  SetUpIfEnabled(telemetry_task, [](auto & task) {
+    task.TrackStack(mp3_player_task);
+    task.TrackStack(audio_buffer_task);
+    task.TrackStack(decoder_task);
+    task.TrackStack(seek_index_task);
+    task.TrackStack(task);
+    task_scheduler.AddTask(&task);
+  });
+  SetUpIfEnabled(display_benchmark_task,
+                 [](auto & task) { task_scheduler.AddTask(&task); });
   task_scheduler.Start();
 
   sjsu::Halt();
@@ -1,87 +1,623 @@
 #pragma once
 
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <optional>
+
 #include "L3_Application/fatfs.hpp"
 #include "L3_Application/task_scheduler.hpp"
+#include "utility/log.hpp"
+#include "utility/time.hpp"
 
 #include "../drivers/audio_decoder.hpp"
-#include "../utility/mp3_file.hpp"
+#include "../utility/audio_block_pool.hpp"
+#include "../utility/file_reader.hpp"
+#include "../utility/histogram.hpp"
+#include "../utility/mp3_frame.hpp"
+#include "../utility/pipeline_config.hpp"
+#include "../utility/seek_table.hpp"
+#include "../utility/song_handle.hpp"
 #include "mp3_player_task.hpp"
 
-template <size_t kBufferLength>
-class AudioDataBufferTask final : public sjsu::rtos::Task<4 * 1024>
+/// Reads songs from the SD card into audio blocks for AudioDataDecodeTask.
+///
+/// Reading is paced by the fill level of the pipeline rather than a timer.
+/// The task reads as fast as possible while blocks are free, then sleeps
+/// until the decoder has drained the pipeline down to the refill watermark
+/// and refills it in a single burst.
+///
+/// The refill watermark holds PipelineConfig::kReadAhead of audio at the
+/// bitrate of the song, so high bitrate songs keep more blocks queued to ride
+/// out SD card stalls, while low bitrate songs wake the task less often to
+/// read larger bursts.
+///
+/// Only the range of a song holding audio frames is read, the tags before and
+/// after it are skipped.
+///
+/// A seek requested with Mp3Player::Command::kSeek discards the queued blocks
+/// and continues reading from the frame found in the song's seek table, with
+/// a single read. Seeks apply to the song playing, so one that arrives after
+/// the task has moved on to prefetch the next song is dropped.
+///
+/// A command that replaces the songs being played, such as skipping to the
+/// next song, abandons the song being read as soon as the task is woken. The
+/// queued blocks are discarded and the first block of the new song cancels
+/// the decoder, so the new song is heard without waiting for the old one to
+/// drain.
+///
+/// Songs are sent to the decoder back to back. Once the last block of a song
+/// is queued, the task opens the next queued song and prefetches its first
+/// blocks while the decoder drains the pipeline. The decoder is not
+/// reinitialized between songs, only a change of format ends the stream, see
+/// StartsStream().
+///
+/// @tparam Pipeline The PipelineConfig of the audio pipeline.
+template <typename Pipeline>
+class AudioDataBufferTask final
+    : public sjsu::rtos::Task<Pipeline::kBufferTaskStackSize>
 {
  public:
+  /// Counters kept for the lifetime of the task.
+  struct Telemetry_t
+  {
+    /// Latency of every f_read.
+    LatencyHistogram<> read_latency;
+    /// Number of blocks discarded because a read failed before the end of
+    /// the file.
+    uint32_t blocks_dropped = 0;
+  };
+
   explicit AudioDataBufferTask(Mp3Player & player)
-      : Task("AudioDataBufferTask", sjsu::rtos::Priority::kLow),
-        decoder_(player.GetDecoder()),
+      : sjsu::rtos::Task<Pipeline::kBufferTaskStackSize>(
+            "AudioDataBufferTask",
+            sjsu::rtos::Priority::kLow),
+        player_(player),
+        block_pool_(player.GetBlockPool()),
         song_queue_(player.GetSongQueue()),
         buffer_queue_(player.GetDataBufferQueue())
   {
-    buffer =
-        reinterpret_cast<uint8_t *>(malloc(kBufferLength * sizeof(uint8_t)));
   }
 
   bool Run() override
   {
-    mp3::Mp3File song;
+    Mp3Player::QueuedSong_t queued;
 
-    if (xQueueReceive(song_queue_, &song, portMAX_DELAY))
+    if (xQueueReceive(song_queue_, &queued, portMAX_DELAY))
     {
-      decoder_.Enable();
+      const mp3::SongHandle_t & song = queued.song;
+      if (queued.generation != player_.GetGeneration())
+      {
+        // Replaced before it was played.
+        return true;
+      }
+      if (queued.generation != generation_)
+      {
+        // The song replaces the one before it, whose blocks may still be
+        // queued if it was read to the end.
+        generation_ = queued.generation;
+        Abandon();
+      }
 
-      FIL fil;
-      UINT bytes_read = 0;
+      if (!player_.GetSongPath(song, path_, sizeof(path_)))
+      {
+        sjsu::LogError("Song %lu no longer exists", song.index);
+        return true;
+      }
+      if (!reader_.Open(path_))
+      {
+        sjsu::LogError("Failed to open %s", path_);
+        return true;
+      }
+      SkipTags(song);
+      // Starts building the song's seek table if it has none.
+      player_.GetSeekTable(song, &seek_table_);
+
+      reader_.ResetStatistics();
+      song_statistics_ = FileReader::Statistics_t{};
+      refill_count_    = 0;
+      song_number_++;
 
-      for (size_t i = 0; i < song.GetFileSize() / kBufferLength; i++)
+      bool is_first_block = true;
+      while (!reader_.IsEndOfFile())
       {
-        if (FR_OK == f_open(&fil, song.GetFilePath(), FA_READ))
+        if (block_pool_.GetFreeCount() == 0)
+        {
+          WaitForRefill();
+        }
+        if (player_.GetGeneration() != generation_)
         {
-          f_lseek(&fil, i * kBufferLength);
-          f_read(&fil, buffer, kBufferLength, &bytes_read);
-          f_close(&fil);
+          break;
         }
 
-        xQueueSend(buffer_queue_, buffer, portMAX_DELAY);
-        vTaskDelay(15);
+        std::chrono::milliseconds seek_position;
+        const bool kIsSeek =
+            player_.TakeSeek(song_number_, &seek_position);
+        if (kIsSeek)
+        {
+          SeekTo(song, seek_position);
+        }
+
+        AudioBlock_t * block = block_pool_.Acquire();
+        block->length =
+            reader_.Read(block->data, Pipeline::kBlockLength);
+        if (block->length == 0)
+        {
+          telemetry_.blocks_dropped++;
+          block_pool_.Release(block);
+          break;
+        }
+        telemetry_.read_latency.Record(reader_.GetLastLatency());
+        block->is_last     = reader_.IsEndOfFile();
+        block->song_number = song_number_;
+        block->song        = song;
+        block->generation  = generation_;
+        if (is_first_block)
+        {
+          block->starts_stream = StartsStream(*block);
+          is_first_block       = false;
+        }
+        if (kIsSeek)
+        {
+          AlignToFrame(block, seek_position);
+        }
+        block->starts_stream  = block->starts_stream || is_start_pending_;
+        block->cancels_stream = is_cancel_pending_;
+        is_start_pending_     = false;
+        is_cancel_pending_    = false;
+
+        xQueueSend(buffer_queue_, &block, portMAX_DELAY);
+
+        if (reader_.GetStatistics().bytes_read >= kStatisticsInterval)
+        {
+          LogStatistics();
+          song_statistics_.Add(reader_.GetStatistics());
+          reader_.ResetStatistics();
+          refill_count_ = 0;
+        }
       }
+      LogStatistics();
+      song_statistics_.Add(reader_.GetStatistics());
+      reader_.Close();
     }
 
     return true;
   }
 
+  const Telemetry_t & GetTelemetry() const
+  {
+    return telemetry_;
+  }
+
+  /// @returns The read statistics of the current song, complete once the
+  ///          song's last block has been queued.
+  const FileReader::Statistics_t & GetSongStatistics() const
+  {
+    return song_statistics_;
+  }
+
+  /// @returns The number of queued blocks at which the pipeline was last
+  ///          refilled.
+  size_t GetRefillWatermark() const
+  {
+    return refill_watermark_;
+  }
+
+  /// @returns The number of fragments of the current song, see
+  ///          FileReader::GetFragmentCount().
+  uint32_t GetSongFragmentCount() const
+  {
+    return reader_.GetFragmentCount();
+  }
+
  private:
-  const AudioDecoder & decoder_;
+  /// Number of bytes to read before logging the SD card throughput. Logging
+  /// per interval rather than per song shows whether the throughput stays flat
+  /// from the start of a track to its end.
+  static constexpr size_t kStatisticsInterval = 64 * 1024;
+
+  /// Restricts reading to the song's audio frames. The decoder discards tags,
+  /// so reading and sending them, cover art especially, only delays the first
+  /// frame and wastes SD card and SPI bandwidth.
+  void SkipTags(const mp3::SongHandle_t & song)
+  {
+    if (!player_.GetSongMetadata(song, &metadata_))
+    {
+      metadata_ = mp3::Metadata_t{};
+      return;
+    }
+    if (!reader_.SetRange(metadata_.audio_start, metadata_.audio_end))
+    {
+      return;
+    }
+    sjsu::LogDebug("Skipped %lu B of tags",
+                   static_cast<uint32_t>(reader_.GetSize() -
+                                         (metadata_.audio_end -
+                                          metadata_.audio_start)));
+  }
+
+  /// Discards the blocks queued for the decoder and has the next block
+  /// cancel the audio the decoder holds, so that the next block is heard
+  /// immediately.
+  void Abandon()
+  {
+    AudioBlock_t * queued = nullptr;
+    while (xQueueReceive(buffer_queue_, &queued, 0))
+    {
+      // A discarded block that was to start the decoder passes the start on
+      // to the next block.
+      is_start_pending_ = is_start_pending_ || queued->starts_stream;
+      block_pool_.Release(queued);
+    }
+    // Before the first song there is nothing to cancel.
+    is_cancel_pending_ = has_stream_;
+  }
+
+  /// Moves reading to a position of the song. The blocks queued for the
+  /// decoder are discarded, so the position is heard as soon as the decoder
+  /// has cancelled the audio it holds.
+  ///
+  /// The position is found in the song's seek table. Until the table covers
+  /// the position, it is estimated from the song's duration, which is exact
+  /// only for constant bitrate songs.
+  void SeekTo(const mp3::SongHandle_t & song,
+              std::chrono::milliseconds position)
+  {
+    Abandon();
+
+    uint32_t offset = metadata_.audio_start;
+    seek_time_      = 0ms;
+    std::optional<mp3::SeekTable::Position_t> entry;
+    if (player_.GetSeekTable(song, &seek_table_))
+    {
+      entry = seek_table_.Find(position);
+    }
+    if (entry)
+    {
+      offset     = entry->offset;
+      seek_time_ = entry->time;
+    }
+    else if (metadata_.duration != 0)
+    {
+      const uint64_t kLength = metadata_.audio_end - metadata_.audio_start;
+      const uint64_t kTime   = std::min<uint64_t>(position.count(),
+                                                metadata_.duration);
+      offset += static_cast<uint32_t>(kLength * kTime / metadata_.duration);
+      seek_time_ = std::chrono::milliseconds(kTime);
+    }
+    // Seeking past the end still reads a byte, so the song's last block is
+    // marked as such.
+    if (metadata_.audio_end > metadata_.audio_start)
+    {
+      offset = std::min(offset, metadata_.audio_end - 1);
+    }
+    reader_.Seek(offset);
+  }
+
+  /// Drops the bytes of the first block read after a seek that come before
+  /// the first frame header, then the whole frames before the requested
+  /// position, so that the decoder starts on a frame boundary.
+  void AlignToFrame(AudioBlock_t * block, std::chrono::milliseconds position)
+  {
+    mp3::FrameHeader_t header;
+    size_t offset = mp3::FindFrame(block->data, block->length, &header);
+    if (offset == block->length)
+    {
+      // The decoder resynchronizes on its own.
+      return;
+    }
+
+    // Frames are stepped over in microseconds to avoid accumulating rounding
+    // errors.
+    const auto kFrameTime = std::chrono::microseconds(
+        uint64_t{ header.samples_per_frame } * 1'000'000 / header.sample_rate);
+    std::chrono::microseconds time = seek_time_;
+    while (time + kFrameTime <= position &&
+           offset + header.length + mp3::FrameHeader_t::kSize <= block->length)
+    {
+      const auto kNext =
+          mp3::FrameHeader_t::Parse(&block->data[offset + header.length]);
+      if (!kNext)
+      {
+        break;
+      }
+      offset += header.length;
+      time += kFrameTime;
+      header = *kNext;
+    }
+
+    std::memmove(block->data, &block->data[offset], block->length - offset);
+    block->length -= offset;
+    sjsu::LogDebug("Seek to %lld ms landed at %lld ms",
+                   static_cast<long long>(position.count()),
+                   static_cast<long long>(time.count() / 1000));
+  }
+
+  /// Decides whether the decoder must be started for a song. Songs are sent
+  /// back to back so that the decoder continues from one into the next,
+  /// which it handles as long as the MPEG version and sample rate stay the
+  /// same.
+  ///
+  /// @param block The first block of the song.
+  /// @returns True for the first song played, or if the song's first frame
+  ///          differs in format from the previous song's.
+  bool StartsStream(const AudioBlock_t & block)
+  {
+    const bool kIsFirstSong = !has_stream_;
+    has_stream_             = true;
+
+    // Without a frame header the song is left to continue the stream, the
+    // decoder resynchronizes on its first frame.
+    mp3::FrameHeader_t header;
+    if (mp3::FindFrame(block.data, block.length, &header) == block.length)
+    {
+      return kIsFirstSong;
+    }
+
+    const mp3::FrameHeader_t kPrevious = stream_format_;
+    stream_format_                     = header;
+
+    const bool kIsNewFormat = kPrevious.sample_rate != 0 &&
+                              (header.is_mpeg1 != kPrevious.is_mpeg1 ||
+                               header.sample_rate != kPrevious.sample_rate);
+    return kIsFirstSong || kIsNewFormat;
+  }
+
+  /// Sleeps until the decoder has consumed enough of the pipeline.
+  void WaitForRefill()
+  {
+    UpdateRefillWatermark();
+    // Blocks not queued and not free are held by the decoder, so waiting for
+    // this many free blocks wakes the task at or below the watermark.
+    block_pool_.WaitForFree(block_pool_.GetBlockCount() - refill_watermark_);
+    refill_count_++;
+  }
+
+  /// Sizes the refill watermark for the bitrate of the song. The bitrate of
+  /// a variable bitrate song changes from frame to frame, so the higher of
+  /// its average and the bitrate of the frame being decoded is used. The
+  /// latter is recorded by AudioDataDecodeTask, so refilling never waits on
+  /// the decoder.
+  void UpdateRefillWatermark()
+  {
+    uint32_t bitrate = stream_format_.bitrate;
+    if (metadata_.duration != 0)
+    {
+      bitrate = static_cast<uint32_t>(
+          uint64_t{ metadata_.audio_end - metadata_.audio_start } * 8'000 /
+          metadata_.duration);
+    }
+
+    bitrate = std::max(bitrate, player_.GetDecodedBitrate());
+    if (bitrate != 0)
+    {
+      refill_watermark_ = Pipeline::GetRefillWatermark(bitrate);
+    }
+  }
+
+  void LogStatistics() const
+  {
+    const auto & statistics = reader_.GetStatistics();
+    if (statistics.read_count == 0)
+    {
+      return;
+    }
+    sjsu::LogDebug("SD @ %zu: %lu B/s, latency min/avg/max: %lld/%lld/%lld us, "
+                   "%lu refills at %zu blocks",
+                   reader_.GetPosition(),
+                   statistics.GetBytesPerSecond(),
+                   statistics.min_latency.count(),
+                   statistics.GetAverageLatency().count(),
+                   statistics.max_latency.count(),
+                   refill_count_,
+                   refill_watermark_);
+  }
+
+  Mp3Player & player_;
+  const AudioBlockPool & block_pool_;
   const QueueHandle_t song_queue_;
   const QueueHandle_t buffer_queue_;
 
-  uint8_t * buffer;
+  /// Path of the song being read.
+  char path_[256] = "";
+  /// Metadata of the song being read.
+  mp3::Metadata_t metadata_ = {};
+  /// Seek table of the song being read.
+  mp3::SeekTable seek_table_;
+  /// Playback time of the offset found by the last seek.
+  std::chrono::milliseconds seek_time_ = 0ms;
+  FileReader reader_;
+  FileReader::Statistics_t song_statistics_;
+  Telemetry_t telemetry_;
+  uint32_t refill_count_   = 0;
+  size_t refill_watermark_ = Pipeline::kRefillWatermark;
+  /// Format of the first frame of the last song that had one, used to detect
+  /// songs the decoder must be restarted for.
+  mp3::FrameHeader_t stream_format_ = {};
+  bool has_stream_                  = false;
+  /// Mp3Player::GetGeneration() of the song being read.
+  uint32_t generation_ = 0;
+  /// AudioBlock_t::song_number of the song being read.
+  uint32_t song_number_ = 0;
+  /// Set when blocks are discarded, for the next block queued.
+  bool is_start_pending_  = false;
+  bool is_cancel_pending_ = false;
 };
 
-template <size_t kBufferLength>
-class AudioDataDecodeTask final : public sjsu::rtos::Task<512>
+/// Passes the blocks queued by AudioDataBufferTask to the decoder.
+///
+/// @tparam Pipeline The PipelineConfig of the audio pipeline.
+template <typename Pipeline>
+class AudioDataDecodeTask final
+    : public sjsu::rtos::Task<Pipeline::kDecodeTaskStackSize>
 {
  public:
+  /// Counters describing how well the pipeline kept up with the decoder.
+  struct Statistics_t
+  {
+    /// Number of bytes passed to the decoder.
+    uint64_t bytes_buffered = 0;
+    /// Number of songs whose last block was passed to the decoder.
+    uint32_t songs_completed = 0;
+    /// Longest time spent waiting for a block in the middle of a song.
+    std::chrono::microseconds max_block_wait = 0us;
+  };
+
+  /// Counters kept for the lifetime of the task.
+  struct Telemetry_t
+  {
+    /// Most blocks seen queued when taking a block mid-song.
+    size_t queue_high_watermark = 0;
+    /// Fewest blocks seen queued when taking a block mid-song.
+    size_t queue_low_watermark = SIZE_MAX;
+    /// Number of times the decoder was started for a song, rather than the
+    /// song continuing the previous one's stream.
+    uint32_t streams_started = 0;
+    /// Uptime at which the first block of the latest song, or the first block
+    /// after a seek, had been passed to the decoder.
+    std::chrono::microseconds last_start_time = 0us;
+  };
+
+  /// Number of blocks passed to the decoder between reads of the bitrate of
+  /// the frame being decoded, see Mp3Player::SetDecodedBitrate().
+  static constexpr size_t kBitrateInterval = 16;
+
   AudioDataDecodeTask(Mp3Player & player)
-      : Task("AudioDataDecodeTask", sjsu::rtos::Priority::kLow),
+      : sjsu::rtos::Task<Pipeline::kDecodeTaskStackSize>(
+            "AudioDataDecodeTask",
+            sjsu::rtos::Priority::kLow),
+        player_(player),
         decoder_(player.GetDecoder()),
+        block_pool_(player.GetBlockPool()),
         buffer_queue_(player.GetDataBufferQueue())
   {
-    buffer =
-        reinterpret_cast<uint8_t *>(malloc(kBufferLength * sizeof(uint8_t)));
   }
 
   bool Run() override
   {
-    if (xQueueReceive(buffer_queue_, buffer, portMAX_DELAY))
+    if (is_streaming_)
+    {
+      const size_t kQueued = uxQueueMessagesWaiting(buffer_queue_);
+      if (kQueued == 0)
+      {
+        underrun_count_++;
+      }
+      telemetry_.queue_high_watermark =
+          std::max(telemetry_.queue_high_watermark, kQueued);
+      telemetry_.queue_low_watermark =
+          std::min(telemetry_.queue_low_watermark, kQueued);
+    }
+
+    AudioBlock_t * block  = nullptr;
+    const auto kStartTime = sjsu::Uptime();
+    if (xQueueReceive(buffer_queue_, &block, portMAX_DELAY))
     {
-      decoder_.Buffer(buffer, kBufferLength);
+      if (is_streaming_)
+      {
+        statistics_.max_block_wait = std::max(
+            statistics_.max_block_wait,
+            std::chrono::duration_cast<std::chrono::microseconds>(
+                sjsu::Uptime() - kStartTime));
+      }
+
+      if (block->cancels_stream)
+      {
+        decoder_.Cancel();
+      }
+      if (block->starts_stream)
+      {
+        StartStream();
+      }
+      if (block->song_number != song_number_)
+      {
+        song_number_ = block->song_number;
+        player_.SetPlayingSong(*block);
+        player_.SetDecodedBitrate(0);
+        blocks_until_bitrate_ = kBitrateInterval;
+      }
+      decoder_.Buffer(block->data, block->length);
+      if (--blocks_until_bitrate_ == 0)
+      {
+        UpdateBitrate();
+        blocks_until_bitrate_ = kBitrateInterval;
+      }
+      if (!is_streaming_ || block->cancels_stream)
+      {
+        telemetry_.last_start_time =
+            std::chrono::duration_cast<std::chrono::microseconds>(
+                sjsu::Uptime());
+      }
+      statistics_.bytes_buffered += block->length;
+      if (block->is_last)
+      {
+        statistics_.songs_completed++;
+      }
+      is_streaming_ = !block->is_last;
+      block_pool_.Release(block);
     }
     return true;
   }
 
+  /// @returns The number of times a block was not ready when the decoder
+  ///          needed one in the middle of a song.
+  uint32_t GetUnderrunCount() const
+  {
+    return underrun_count_;
+  }
+
+  const Statistics_t & GetStatistics() const
+  {
+    return statistics_;
+  }
+
+  const Telemetry_t & GetTelemetry() const
+  {
+    return telemetry_;
+  }
+
+  /// Clears the statistics, should only be called between songs.
+  void ResetStatistics()
+  {
+    statistics_ = Statistics_t{};
+  }
+
  private:
+  /// Starts the decoder, first ending the previous stream if there is one.
+  /// Starting the decoder here rather than in the buffer task ensures the
+  /// previous song has been sent in full.
+  void StartStream()
+  {
+    if (has_stream_)
+    {
+      decoder_.EndStream();
+    }
+    decoder_.Enable();
+    has_stream_ = true;
+    telemetry_.streams_started++;
+  }
+
+  /// Reads the bitrate of the frame being decoded for AudioDataBufferTask.
+  void UpdateBitrate()
+  {
+    AudioDecoder::StreamInfo_t info;
+    if (decoder_.GetStreamInfo(&info))
+    {
+      player_.SetDecodedBitrate(info.bitrate);
+    }
+  }
+
+  Mp3Player & player_;
   const AudioDecoder & decoder_;
+  const AudioBlockPool & block_pool_;
   const QueueHandle_t buffer_queue_;
 
-  uint8_t * buffer;
+  bool has_stream_         = false;
+  bool is_streaming_       = false;
+  uint32_t underrun_count_ = 0;
+  /// AudioBlock_t::song_number of the song being passed to the decoder.
+  uint32_t song_number_ = 0;
+  /// Blocks left to pass to the decoder before the bitrate is read again.
+  size_t blocks_until_bitrate_ = kBitrateInterval;
+  Statistics_t statistics_;
+  Telemetry_t telemetry_;
 };
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+#include "L3_Application/task_scheduler.hpp"
+#include "utility/log.hpp"
+#include "utility/time.hpp"
+
+#include "../drivers/st7735.hpp"
+#include "../graphics/graphics.hpp"
+#include "../graphics/text_renderer.hpp"
+#include "audio_data_buffer_task.hpp"
+
+/// Stress benchmark for the shared SPI bus. Repeatedly redraws the entire
+/// display while audio is playing and reports how long each redraw took and
+/// how many audio underruns occurred during the redraws.
+///
+/// Start playback of a high bitrate (320 kbps) file to stress the bus.
+///
+/// Each report alternates between the RGB565 and RGB666 pixel formats so the
+/// cost of each can be compared.
+template <typename Pipeline>
+class DisplayBenchmarkTask final : public sjsu::rtos::Task<1024>
+{
+ public:
+  /// Number of full screen redraws per report.
+  static constexpr uint32_t kRedrawCount = 20;
+
+  DisplayBenchmarkTask(St7735 & display,
+                       const AudioDataDecodeTask<Pipeline> & decoder_task)
+      : Task("DisplayBenchmarkTask", sjsu::rtos::Priority::kLow),
+        display_(display),
+        decoder_task_(decoder_task),
+        text_renderer_(display),
+        counter_field_(text_renderer_,
+                       graphics::Point_t{ .x = 0, .y = 0 },
+                       graphics::TextRenderer::Style_t{ .scale = 2 })
+  {
+  }
+
+  bool Run() override
+  {
+    constexpr graphics::Color_t kColors[] = { graphics::kRed,
+                                              graphics::kGreen,
+                                              graphics::kBlue };
+
+    const St7735::PixelFormat kFormat =
+        (report_count_++ % 2 == 0) ? St7735::PixelFormat::kRgb565
+                                   : St7735::PixelFormat::kRgb666;
+    display_.SetPixelFormat(kFormat);
+
+    const uint32_t kStartUnderruns = decoder_task_.GetUnderrunCount();
+    std::chrono::microseconds total_time = 0us;
+    std::chrono::microseconds max_time   = 0us;
+
+    for (uint32_t i = 0; i < kRedrawCount; i++)
+    {
+      const auto kStartTime = sjsu::Uptime();
+      display_.FillFrame(graphics::Frame_t(0,
+                                           0,
+                                           display_.GetWidth(),
+                                           display_.GetHeight()),
+                         kColors[i % std::size(kColors)]);
+      const auto kRedrawTime =
+          std::chrono::duration_cast<std::chrono::microseconds>(
+              sjsu::Uptime() - kStartTime);
+
+      total_time += kRedrawTime;
+      max_time = std::max(max_time, kRedrawTime);
+    }
+
+    sjsu::LogInfo("%s %lu redraws: avg %lld us, max %lld us, %lu underruns",
+                  (kFormat == St7735::PixelFormat::kRgb565) ? "RGB565"
+                                                            : "RGB666",
+                  kRedrawCount,
+                  (total_time / kRedrawCount).count(),
+                  max_time.count(),
+                  decoder_task_.GetUnderrunCount() - kStartUnderruns);
+
+    // Measure the in-place update of a changing field, like a clock.
+    counter_field_.Invalidate();
+    const auto kTextStartTime = sjsu::Uptime();
+    for (uint32_t i = 0; i < kRedrawCount; i++)
+    {
+      char text[8];
+      snprintf(text, sizeof(text), "%05u", static_cast<unsigned>(i));
+      counter_field_.SetText(text);
+      display_.Update();
+    }
+    sjsu::LogInfo("%lu text field updates: avg %lld us",
+                  kRedrawCount,
+                  (std::chrono::duration_cast<std::chrono::microseconds>(
+                       sjsu::Uptime() - kTextStartTime) /
+                   kRedrawCount)
+                      .count());
+
+    vTaskDelay(1000);
+    return true;
+  }
+
+ private:
+  St7735 & display_;
+  const AudioDataDecodeTask<Pipeline> & decoder_task_;
+  graphics::TextRenderer text_renderer_;
+  graphics::TextField<5> counter_field_;
+  uint32_t report_count_ = 0;
+};
@@ -1,37 +1,192 @@
 #pragma once
 
 #include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 
 #include "L3_Application/fatfs.hpp"
 #include "L3_Application/task_scheduler.hpp"
+#include "utility/log.hpp"
 
 #include "../drivers/audio_decoder.hpp"
-#include "../utility/mp3_file.hpp"
+#include "../utility/audio_block_pool.hpp"
+#include "../utility/file_system_lock.hpp"
+#include "../utility/library_index.hpp"
+#include "../utility/metadata_cache.hpp"
+#include "../utility/metadata_parser.hpp"
+#include "../utility/pipeline_config.hpp"
+#include "../utility/seek_index.hpp"
+#include "../utility/seek_table.hpp"
+#include "../utility/song_catalog.hpp"
+#include "../utility/song_handle.hpp"
+#include "../utility/static_queue.hpp"
 
 class Mp3Player
 {
  public:
-  virtual const AudioDecoder & GetDecoder() const  = 0;
-  virtual QueueHandle_t GetSongQueue() const       = 0;
-  virtual QueueHandle_t GetDataBufferQueue() const = 0;
+  /// Controls of the player, see SendCommand().
+  enum class Command : uint8_t
+  {
+    /// Plays the song at library index `argument`, or `song` if it is set.
+    kPlay,
+    kPause,
+    kResume,
+    kNext,
+    kPrevious,
+    /// Continues the song being played from `argument` milliseconds.
+    kSeek,
+    /// Sets the volume to `argument` percent.
+    kSetVolume,
+  };
+
+  /// A command and its argument.
+  struct Command_t
+  {
+    Command type;
+    int32_t argument       = 0;
+    mp3::SongHandle_t song = {};
+  };
+
+  /// Result of a command.
+  enum class CommandStatus : uint8_t
+  {
+    kDone,
+    /// The song does not exist.
+    kNotFound,
+    /// The argument is out of range.
+    kInvalidArgument,
+    /// The player did not take or complete the command in time.
+    kTimeout,
+  };
+
+  /// An entry of the song queue.
+  struct QueuedSong_t
+  {
+    mp3::SongHandle_t song;
+    /// Value of GetGeneration() when the song was queued.
+    uint32_t generation;
+  };
+
+  virtual const AudioDecoder & GetDecoder() const     = 0;
+  virtual const AudioBlockPool & GetBlockPool() const = 0;
+  /// @returns Queue of `QueuedSong_t` songs to be played.
+  virtual QueueHandle_t GetSongQueue() const          = 0;
+  /// @returns Queue of `AudioBlock_t *` handles ready to be decoded.
+  virtual QueueHandle_t GetDataBufferQueue() const    = 0;
+
+  /// Sends a command to the player and waits for it to be carried out.
+  ///
+  /// @param command The command.
+  /// @param timeout Time to wait for the player to take the command and again
+  ///                for it to complete.
+  /// @returns The result of the command.
+  virtual CommandStatus SendCommand(const Command_t & command,
+                                    TickType_t timeout = portMAX_DELAY) = 0;
+
+  /// Queues a song after the songs already queued.
+  ///
+  /// @param song The song.
+  /// @param timeout Time to wait for room in the song queue.
+  /// @returns False if the queue stayed full.
+  virtual bool QueueSong(const mp3::SongHandle_t & song,
+                         TickType_t timeout) = 0;
+
+  /// @returns The number of times the songs being played were replaced by a
+  ///          command. Songs queued under an older generation are skipped,
+  ///          and the song being read is abandoned.
+  virtual uint32_t GetGeneration() const = 0;
+
+  /// @returns A handle to play a file that is not in the library.
+  virtual mp3::SongHandle_t AddSongPath(const char * path) = 0;
+
+  /// Looks up the path of a song from the song queue.
+  ///
+  /// @param song The song.
+  /// @param path Destination buffer.
+  /// @param length Size of the destination buffer.
+  /// @returns False if the song no longer exists.
+  virtual bool GetSongPath(const mp3::SongHandle_t & song,
+                           char * path,
+                           size_t length) = 0;
+
+  /// Looks up the title, artist, album and duration of a song.
+  ///
+  /// @param song The song.
+  /// @param metadata Set to the song's metadata.
+  /// @returns False if the song no longer exists.
+  virtual bool GetSongMetadata(const mp3::SongHandle_t & song,
+                               mp3::Metadata_t * metadata) = 0;
+
+  /// Records the song whose blocks are being passed to the decoder, which is
+  /// the song a seek applies to and the song skipped from.
+  ///
+  /// @param block The first block of the song passed to the decoder.
+  virtual void SetPlayingSong(const AudioBlock_t & block) = 0;
+
+  /// Takes the position of the latest seek requested with Command::kSeek.
+  /// A seek requested for another song than the one being read is dropped,
+  /// so that a seek made while the next song is prefetched does not land in
+  /// it.
+  ///
+  /// @param song_number AudioBlock_t::song_number of the song being read.
+  /// @param position Set to the requested position.
+  /// @returns False if no seek is pending for the song.
+  virtual bool TakeSeek(uint32_t song_number,
+                        std::chrono::milliseconds * position) = 0;
+
+  /// Records the bitrate of the frame being decoded. It is read from the
+  /// decoder by AudioDataDecodeTask, which already waits for the decoder to
+  /// be ready, so that AudioDataBufferTask never waits on the decoder.
+  ///
+  /// @param bitrate Bitrate in bits per second, 0 if not known yet.
+  virtual void SetDecodedBitrate(uint32_t bitrate) = 0;
+
+  /// @returns The bitrate given to SetDecodedBitrate().
+  virtual uint32_t GetDecodedBitrate() const = 0;
+
+  /// Copies the seek table of a song. Songs without a table have one built in
+  /// the background.
+  ///
+  /// @param song The song.
+  /// @param table Set to the song's table, which may cover only part of the
+  ///              song while it is being built.
+  /// @returns False if the song has no table yet.
+  virtual bool GetSeekTable(const mp3::SongHandle_t & song,
+                            mp3::SeekTable * table) = 0;
 };
 
-class Mp3PlayerTask final : public sjsu::rtos::Task<256>,
-                            public virtual Mp3Player
+/// @tparam Pipeline The PipelineConfig of the audio pipeline, which sizes the
+///         block pool and the queue of blocks for the decoder.
+template <typename Pipeline>
+class Mp3PlayerTask final
+    : public sjsu::rtos::Task<Pipeline::kPlayerTaskStackSize>,
+      public virtual Mp3Player
 {
  public:
-  static constexpr size_t kSongQueueLength = 2;
-  static constexpr size_t kBufferItemCount = 3;
-  static constexpr size_t kBufferLength    = 1024;
+  static constexpr size_t kSongQueueLength    = 2;
+  static constexpr size_t kCommandQueueLength = 4;
+  /// Interval at which the song queue is topped up while waiting for
+  /// commands.
+  static constexpr TickType_t kQueuePollPeriod = pdMS_TO_TICKS(100);
+  /// Number of songs of the library kept in RAM.
+  static constexpr size_t kCatalogWindowSize = 8;
+  /// Number of songs whose metadata is kept in RAM.
+  static constexpr size_t kMetadataCacheSize = 8;
 
-  explicit Mp3PlayerTask(AudioDecoder & audio_decoder)
-      : Task("Mp3PlayerTask", sjsu::rtos::Priority::kLow),
+  /// @param audio_decoder The decoder the songs are played on.
+  /// @param block_storage The payloads of the pipeline's audio blocks.
+  Mp3PlayerTask(AudioDecoder & audio_decoder,
+                typename Pipeline::BlockStorage & block_storage)
+      : sjsu::rtos::Task<Pipeline::kPlayerTaskStackSize>(
+            "Mp3PlayerTask",
+            sjsu::rtos::Priority::kLow),
         audio_decoder_(audio_decoder),
-        song_list_count_(0)
+        catalog_(library_),
+        block_pool_(block_storage)
   {
-    song_queue_ = xQueueCreate(kSongQueueLength, sizeof(mp3::Mp3File));
-    buffer_queue_ =
-        xQueueCreate(kBufferItemCount, kBufferLength * sizeof(uint8_t));
+    sender_mutex_ = xSemaphoreCreateMutexStatic(&sender_mutex_buffer_);
   }
 
   // ---------------------------------------------------------------------------
@@ -40,19 +195,110 @@ class Mp3PlayerTask final : public sjsu::rtos::Task<256>,
 
   bool Setup() override
   {
-    FetchSongs();
-    Play(0);
+    if (!library_.Open())
+    {
+      sjsu::LogError("Failed to open %s", mp3::LibraryIndex::kIndexPath);
+    }
+    // The index is only empty on the first boot with a card, verifying the
+    // first few songs makes them playable without waiting for a full scan.
+    while (library_.GetCount() == 0 && !library_.Update())
+    {
+      continue;
+    }
+    if (auto_play_)
+    {
+      Play(0);
+    }
     return true;
   }
 
+  /// Carries out commands as they arrive, and between them keeps the song
+  /// queue filled with the songs following the last one queued.
   bool Run() override
   {
+    // Commands are waited for only as long as there is nothing else to do,
+    // so that they are carried out as soon as they are sent.
+    TickType_t timeout = portMAX_DELAY;
+    if (!library_.IsVerified())
+    {
+      timeout = 0;
+    }
+    else if (is_queueing_)
+    {
+      timeout = kQueuePollPeriod;
+    }
+
+    Request_t request;
+    if (xQueueReceive(command_queue_.GetHandle(), &request, timeout))
+    {
+      const Reply_t kReply = {
+        .sequence = request.sequence,
+        .status   = Handle(request.command),
+      };
+      xQueueOverwrite(reply_queue_.GetHandle(), &kReply);
+    }
+
+    if (!library_.IsVerified())
+    {
+      // Songs added to or removed from the card since the last boot are
+      // picked up by verifying the index in the background, a few songs at a
+      // time.
+      const mp3::SongHandle_t kCursor =
+          library_.GetHandle(catalog_.GetPosition());
+      if (library_.Update())
+      {
+        catalog_.Invalidate();
+        if (library_.GetGeneration() != kCursor.generation)
+        {
+          RemapSongs(kCursor);
+        }
+      }
+    }
+    if (is_queueing_)
+    {
+      is_queueing_ = QueueNextSong(0);
+    }
     return true;
   }
 
-  void Play(uint32_t index)
+  /// Replaces the songs being played with a song of the library, the songs
+  /// after it are queued as the queue drains.
+  ///
+  /// @param index Index of the song in the library.
+  /// @returns CommandStatus::kNotFound if there is no such song.
+  CommandStatus Play(uint32_t index)
   {
-    xQueueSend(song_queue_, &song_list_[index], portMAX_DELAY);
+    const auto * song = catalog_.Seek(index);
+    if (song == nullptr)
+    {
+      return CommandStatus::kNotFound;
+    }
+    Replace(song->handle);
+    is_queueing_ = auto_play_;
+    return CommandStatus::kDone;
+  }
+
+  /// @returns The seek tables, built by SeekIndexTask.
+  mp3::SeekIndex & GetSeekIndex()
+  {
+    return seek_index_;
+  }
+
+  /// @param repeat True to play the library again from the start once its
+  ///               last song has been queued. Enabled by default.
+  void SetRepeat(bool repeat)
+  {
+    repeat_ = repeat;
+  }
+
+  /// @param auto_play True to play the library from its first song at startup
+  ///                  and queue the songs following the one played. When
+  ///                  false, only the songs named by commands and
+  ///                  QueueSong() are played. Enabled by default, must be
+  ///                  set before the scheduler starts.
+  void SetAutoPlay(bool auto_play)
+  {
+    auto_play_ = auto_play;
   }
 
   // ---------------------------------------------------------------------------
@@ -64,51 +310,401 @@ class Mp3PlayerTask final : public sjsu::rtos::Task<256>,
     return audio_decoder_;
   }
 
+  const AudioBlockPool & GetBlockPool() const override
+  {
+    return block_pool_;
+  }
+
   QueueHandle_t GetSongQueue() const override
   {
-    return song_queue_;
+    return song_queue_.GetHandle();
   }
 
   QueueHandle_t GetDataBufferQueue() const override
   {
-    return buffer_queue_;
+    return buffer_queue_.GetHandle();
   }
 
- private:
-  void FetchSongs()
+  /// Callers are served one at a time, and the reply is sent through
+  /// reply_queue_ rather than the caller's task notification, which the SSP
+  /// DMA driver waits on. A reply to an earlier command that timed out carries
+  /// an older sequence number and is discarded.
+  CommandStatus SendCommand(const Command_t & command,
+                            TickType_t timeout) override
+  {
+    if (!xSemaphoreTake(sender_mutex_, timeout))
+    {
+      return CommandStatus::kTimeout;
+    }
+
+    const Request_t kRequest = {
+      .command  = command,
+      .sequence = ++command_sequence_,
+    };
+    CommandStatus status = CommandStatus::kTimeout;
+    if (xQueueSend(command_queue_.GetHandle(), &kRequest, timeout))
+    {
+      TimeOut_t time_out;
+      vTaskSetTimeOutState(&time_out);
+      Reply_t reply;
+      while (xQueueReceive(reply_queue_.GetHandle(), &reply, timeout))
+      {
+        if (reply.sequence == kRequest.sequence)
+        {
+          status = reply.status;
+          break;
+        }
+        if (xTaskCheckForTimeOut(&time_out, &timeout))
+        {
+          break;
+        }
+      }
+    }
+
+    xSemaphoreGive(sender_mutex_);
+    return status;
+  }
+
+  bool QueueSong(const mp3::SongHandle_t & song, TickType_t timeout) override
+  {
+    const QueuedSong_t kQueued = {
+      .song       = song,
+      .generation = generation_,
+    };
+    return xQueueSend(song_queue_.GetHandle(), &kQueued, timeout) == pdTRUE;
+  }
+
+  uint32_t GetGeneration() const override
+  {
+    return generation_;
+  }
+
+  mp3::SongHandle_t AddSongPath(const char * path) override
   {
-    FILINFO fno;
-    FRESULT res;
-    DIR dir;
+    return path_table_.Add(path);
+  }
+
+  bool GetSongPath(const mp3::SongHandle_t & song,
+                   char * path,
+                   size_t length) override
+  {
+    if (song.source == mp3::SongHandle_t::Source::kPathTable)
+    {
+      return path_table_.GetPath(song, path, length);
+    }
+    return library_.GetPath(song, path, length);
+  }
+
+  /// Songs of the library are looked up in the library index, other songs
+  /// have their tags parsed. Recently used songs are served from a cache, so
+  /// listing the same songs again does not read the SD card.
+  bool GetSongMetadata(const mp3::SongHandle_t & song,
+                       mp3::Metadata_t * metadata) override
+  {
+    if (metadata_cache_.Get(song, metadata))
+    {
+      return true;
+    }
 
-    song_list_count_ = 0;
-    res              = f_findfirst(&dir, &fno, "", "*.mp3");
-    while (res == FR_OK && fno.fname[0])
+    bool is_found = false;
+    if (song.source == mp3::SongHandle_t::Source::kPathTable)
     {
-      if (fno.fname[0] != '.')
+      char path[256];
+      FIL file;
+      if (path_table_.GetPath(song, path, sizeof(path)))
       {
-        mp3::Mp3File mp3_file(fno.fname, fno.fsize);
-        song_list_[song_list_count_++] = mp3_file;
+        FileSystemLock lock;
+        if (f_open(&file, path, FA_READ) == FR_OK)
+        {
+          mp3::MetadataParser parser;
+          parser.Parse(&file, metadata);
+          f_close(&file);
+          is_found = true;
+        }
       }
-      // TODO: should track position and fetch more when needed instead of
-      //       just stopping
-      if (song_list_count_ >= kMaxSongListCount)
+    }
+    else
+    {
+      is_found = library_.GetMetadata(song, metadata);
+    }
+
+    if (is_found)
+    {
+      metadata_cache_.Put(song, *metadata);
+    }
+    return is_found;
+  }
+
+  void SetPlayingSong(const AudioBlock_t & block) override
+  {
+    playing_song_ = block.song_number;
+    // A song replaced before it reached the decoder does not move the song
+    // skipped from, which Replace() already set.
+    if (block.generation == generation_)
+    {
+      xQueueOverwrite(playing_queue_.GetHandle(), &block.song);
+    }
+  }
+
+  bool TakeSeek(uint32_t song_number,
+                std::chrono::milliseconds * position) override
+  {
+    Seek_t seek;
+    if (!xQueueReceive(seek_queue_.GetHandle(), &seek, 0) ||
+        seek.song_number != song_number)
+    {
+      return false;
+    }
+    *position = std::chrono::milliseconds(seek.position);
+    return true;
+  }
+
+  void SetDecodedBitrate(uint32_t bitrate) override
+  {
+    decoded_bitrate_ = bitrate;
+  }
+
+  uint32_t GetDecodedBitrate() const override
+  {
+    return decoded_bitrate_;
+  }
+
+  bool GetSeekTable(const mp3::SongHandle_t & song,
+                    mp3::SeekTable * table) override
+  {
+    if (seek_index_.Get(song, table))
+    {
+      return true;
+    }
+
+    char path[256];
+    mp3::Metadata_t metadata;
+    if (GetSongPath(song, path, sizeof(path)) &&
+        GetSongMetadata(song, &metadata))
+    {
+      seek_index_.Request(
+          song, path, metadata.audio_start, metadata.audio_end);
+    }
+    return false;
+  }
+
+ private:
+  /// Value of playing_song_ before the first song reaches the decoder.
+  static constexpr uint32_t kNoSong = 0;
+
+  /// An entry of the command queue.
+  struct Request_t
+  {
+    Command_t command;
+    /// Number of the request, returned in its reply.
+    uint32_t sequence;
+  };
+
+  /// An entry of the reply queue.
+  struct Reply_t
+  {
+    /// Request_t::sequence of the command.
+    uint32_t sequence;
+    CommandStatus status;
+  };
+
+  /// A seek waiting to be made by AudioDataBufferTask.
+  struct Seek_t
+  {
+    /// AudioBlock_t::song_number of the song playing when it was requested.
+    uint32_t song_number;
+    /// Position in milliseconds.
+    int32_t position;
+  };
+
+  CommandStatus Handle(const Command_t & command)
+  {
+    switch (command.type)
+    {
+      case Command::kPlay:
+        if (command.song.source != mp3::SongHandle_t::Source::kNone)
+        {
+          Replace(command.song);
+          return CommandStatus::kDone;
+        }
+        return (command.argument < 0) ? CommandStatus::kInvalidArgument
+                                      : Play(command.argument);
+      case Command::kPause:
+        audio_decoder_.Pause();
+        return CommandStatus::kDone;
+      case Command::kResume:
+        audio_decoder_.Resume();
+        return CommandStatus::kDone;
+      case Command::kNext: return Skip(1);
+      case Command::kPrevious: return Skip(-1);
+      case Command::kSeek:
+        return Seek(command.argument);
+      case Command::kSetVolume:
+        if (command.argument < 0 || command.argument > 100)
+        {
+          return CommandStatus::kInvalidArgument;
+        }
+        audio_decoder_.SetVolume(static_cast<float>(command.argument) / 100);
+        return CommandStatus::kDone;
+    }
+    return CommandStatus::kInvalidArgument;
+  }
+
+  /// Continues the song playing from a position. The seek is made by
+  /// AudioDataBufferTask, which is woken if it is waiting for the decoder.
+  /// Only the latest of several pending seeks is made, and it is dropped if
+  /// the song has been read to its end by the time the task takes it.
+  ///
+  /// @param position Position in milliseconds.
+  CommandStatus Seek(int32_t position)
+  {
+    if (position < 0)
+    {
+      return CommandStatus::kInvalidArgument;
+    }
+    if (playing_song_ == kNoSong)
+    {
+      return CommandStatus::kNotFound;
+    }
+    const Seek_t kSeek = {
+      .song_number = playing_song_,
+      .position    = position,
+    };
+    xQueueOverwrite(seek_queue_.GetHandle(), &kSeek);
+    block_pool_.Wake();
+    return CommandStatus::kDone;
+  }
+
+  /// Plays the library song a number of songs away from the one playing.
+  CommandStatus Skip(int32_t offset)
+  {
+    const size_t kCount = catalog_.GetCount();
+    if (kCount == 0)
+    {
+      return CommandStatus::kNotFound;
+    }
+    // The catalog's cursor is on the last song queued, which may already be
+    // prefetched while the song before it plays, so the song playing is the
+    // one reported by AudioDataDecodeTask. When that song is not in the
+    // library, the skip is made from the cursor.
+    size_t playing = catalog_.GetPosition();
+    mp3::SongHandle_t song;
+    if (xQueuePeek(playing_queue_.GetHandle(), &song, 0) &&
+        song.source == mp3::SongHandle_t::Source::kLibrary &&
+        library_.Remap(&song))
+    {
+      playing = song.index;
+    }
+    const int32_t kOffset = offset % static_cast<int32_t>(kCount);
+    return Play(static_cast<uint32_t>((playing + kCount + kOffset) % kCount));
+  }
+
+  /// Replaces the songs being played and queued with a song, which is heard
+  /// as soon as AudioDataBufferTask notices the new generation and cancels
+  /// the decoder.
+  void Replace(const mp3::SongHandle_t & song)
+  {
+    generation_++;
+    xQueueReset(song_queue_.GetHandle());
+    QueueSong(song, portMAX_DELAY);
+    xQueueReset(seek_queue_.GetHandle());
+    // A skip made before the song reaches the decoder is made from it.
+    xQueueOverwrite(playing_queue_.GetHandle(), &song);
+    audio_decoder_.Resume();
+    block_pool_.Wake();
+  }
+
+  /// Moves the songs queued before the library index was rebuilt to their
+  /// records in the rebuilt index, so they are played rather than skipped as
+  /// no longer existing, and keeps the catalog's cursor on its song. Songs
+  /// removed from the card are dropped from the queue.
+  ///
+  /// @param cursor Handle of the song under the cursor before the rebuild.
+  void RemapSongs(mp3::SongHandle_t cursor)
+  {
+    if (library_.Remap(&cursor))
+    {
+      catalog_.Seek(cursor.index);
+    }
+
+    std::array<QueuedSong_t, kSongQueueLength> queued;
+    size_t count = 0;
+    while (count < queued.size() &&
+           xQueueReceive(song_queue_.GetHandle(), &queued[count], 0))
+    {
+      count++;
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+      QueuedSong_t & entry = queued[i];
+      if (entry.song.source != mp3::SongHandle_t::Source::kLibrary ||
+          library_.Remap(&entry.song))
       {
-        break;
+        xQueueSend(song_queue_.GetHandle(), &entry, 0);
       }
-      res = f_findnext(&dir, &fno);
     }
-    f_closedir(&dir);
   }
 
-  /// TODO: using max song count of 28 for now, should increase the number of
-  ///       paths from 28 to ??
-  static constexpr size_t kMaxSongListCount = 5;
+  /// Queues the song after the one under the catalog's cursor and moves the
+  /// cursor to it.
+  ///
+  /// @param timeout Time to wait for room in the song queue.
+  /// @returns False if there are no more songs to queue.
+  bool QueueNextSong(TickType_t timeout)
+  {
+    const size_t kCount = catalog_.GetCount();
+    if (kCount == 0)
+    {
+      return false;
+    }
+
+    const size_t kNext = (catalog_.GetPosition() + 1) % kCount;
+    if (kNext == 0 && (!repeat_ || !library_.IsVerified()))
+    {
+      // Songs may still be appended to the library until it is verified.
+      return !library_.IsVerified();
+    }
+
+    const auto * song = catalog_.Get(kNext);
+    if (song != nullptr && QueueSong(song->handle, timeout))
+    {
+      catalog_.Seek(kNext);
+    }
+    return true;
+  }
 
   const AudioDecoder & audio_decoder_;
-  std::array<mp3::Mp3File, kMaxSongListCount> song_list_;
-  size_t song_list_count_;
+  mp3::LibraryIndex library_;
+  mp3::SongCatalog<kCatalogWindowSize> catalog_;
+  bool repeat_    = true;
+  bool auto_play_ = true;
+  /// True while songs of the library are to be queued.
+  bool is_queueing_ = false;
+  std::atomic<uint32_t> generation_ = 0;
+  /// Paths of songs played with AddSongPath(). A path stays valid while it is
+  /// queued, being read, and while the next one waits to be queued.
+  mp3::PathTable<kSongQueueLength + 2> path_table_;
+  mp3::MetadataCache<kMetadataCacheSize> metadata_cache_;
+  mp3::SeekIndex seek_index_;
+  /// AudioBlock_t::song_number of the song playing, or kNoSong.
+  std::atomic<uint32_t> playing_song_ = kNoSong;
+  /// Bitrate of the frame being decoded, see SetDecodedBitrate().
+  std::atomic<uint32_t> decoded_bitrate_ = 0;
 
-  QueueHandle_t song_queue_;
-  QueueHandle_t buffer_queue_;
+  StaticAudioBlockPool<Pipeline::kBlockLength, Pipeline::kBlockCount>
+      block_pool_;
+  StaticQueue<QueuedSong_t, kSongQueueLength> song_queue_;
+  StaticQueue<AudioBlock_t *, Pipeline::kBlockCount> buffer_queue_;
+  StaticQueue<Request_t, kCommandQueueLength> command_queue_;
+  /// Holds the reply to the latest command, overwritten by the next.
+  StaticQueue<Reply_t, 1> reply_queue_;
+  /// Held by the task in SendCommand(), so only one reply is awaited at once.
+  SemaphoreHandle_t sender_mutex_;
+  StaticSemaphore_t sender_mutex_buffer_;
+  /// Request_t::sequence of the last command sent.
+  uint32_t command_sequence_ = 0;
+  /// Holds the latest seek, overwritten by the next.
+  StaticQueue<Seek_t, 1> seek_queue_;
+  /// Holds the song playing, or the song replacing it until it plays.
+  StaticQueue<mp3::SongHandle_t, 1> playing_queue_;
 };
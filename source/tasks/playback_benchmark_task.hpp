@@ -0,0 +1,289 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include "L3_Application/fatfs.hpp"
+#include "L3_Application/task_scheduler.hpp"
+#include "utility/log.hpp"
+#include "utility/time.hpp"
+
+#include "../drivers/vs1053b.hpp"
+#include "../utility/file_system_lock.hpp"
+#include "../utility/song_handle.hpp"
+#include "audio_data_buffer_task.hpp"
+#include "mp3_player_task.hpp"
+
+/// Plays a fixed corpus of MP3 files through the read -> queue ->
+/// Vs1053b::Buffer() path and prints one JSON object per file, so results can
+/// be collected from the serial output and compared across changes to the
+/// buffer length, pipeline depth and SPI clock.
+///
+/// The corpus is listed in kCorpusPath, one `<label> <path>` pair per line.
+/// Blank lines and lines starting with '#' are skipped. For example:
+///
+///   cbr64       /bench/cbr_064.mp3
+///   cbr128      /bench/cbr_128.mp3
+///   cbr320      /bench/cbr_320.mp3
+///   vbr         /bench/vbr_v0.mp3
+///   id3v2_large /bench/id3v2_large_art.mp3
+///   fragmented  /bench/fragmented.mp3
+///
+/// A fragmented file can be produced by copying it onto a card after
+/// interleaving its writes with another file's, so its clusters alternate.
+///
+/// The card is read by the other tasks while files play, so the lock is taken
+/// for each access to the corpus rather than for the whole run.
+///
+/// Each result reports:
+///   - bytes_per_second: bytes delivered to the decoder over the playback time.
+///   - read_bytes_per_second: SD card throughput while inside f_read.
+///   - read_headroom_percent: how much faster the SD card path is than the
+///     rate the decoder consumed data at.
+///   - max_read_latency_us: the slowest single f_read.
+///   - reads: number of f_read calls.
+///   - fragments: fragments of the file, 0 if FatFs fast seek is disabled or
+///     the file has too many to map.
+///   - max_block_wait_us: the longest the decoder waited for a block
+///     mid-song.
+///   - underruns: times a block was not ready when the decoder needed one.
+///
+/// The corpus is then played a second time, each file interrupting the one
+/// before it with a Mp3Player::Command::kPlay command, the way a listener
+/// skips songs. Each result reports:
+///   - skip_latency_us: time from sending the command to the file's first
+///     block having been passed to the decoder.
+template <typename Pipeline>
+class PlaybackBenchmarkTask final : public sjsu::rtos::Task<2048>
+{
+ public:
+  static constexpr const char * kCorpusPath = "/bench/corpus.txt";
+  /// Time without any data reaching the decoder after which a file is
+  /// reported as stalled.
+  static constexpr std::chrono::milliseconds kStallTimeout = 5000ms;
+  /// Interval at which the progress of a file is checked.
+  static constexpr TickType_t kPollPeriod = pdMS_TO_TICKS(50);
+  /// Time each file plays before the next file interrupts it.
+  static constexpr TickType_t kSkipInterval = pdMS_TO_TICKS(2000);
+
+  PlaybackBenchmarkTask(
+      Mp3Player & player,
+      const Vs1053b & decoder,
+      const AudioDataBufferTask<Pipeline> & buffer_task,
+      AudioDataDecodeTask<Pipeline> & decoder_task)
+      : Task("PlaybackBenchmarkTask", sjsu::rtos::Priority::kLow),
+        player_(player),
+        decoder_(decoder),
+        buffer_task_(buffer_task),
+        decoder_task_(decoder_task)
+  {
+  }
+
+  bool Run() override
+  {
+    FIL corpus;
+    if (!Open(&corpus))
+    {
+      sjsu::LogError("Failed to open benchmark corpus %s", kCorpusPath);
+    }
+    else
+    {
+      char line[300];
+      const char * path = nullptr;
+      while (ReadEntry(&corpus, line, &path))
+      {
+        RunFile(line, path);
+      }
+      {
+        FileSystemLock lock;
+        f_lseek(&corpus, 0);
+      }
+      while (ReadEntry(&corpus, line, &path))
+      {
+        RunSkip(line, path);
+      }
+      {
+        FileSystemLock lock;
+        f_close(&corpus);
+      }
+      std::printf("{\"benchmark\":\"done\"}\n");
+    }
+
+    // The corpus is only played once.
+    vTaskSuspend(nullptr);
+    return true;
+  }
+
+ private:
+  /// @returns False if kCorpusPath could not be opened.
+  static bool Open(FIL * corpus)
+  {
+    FileSystemLock lock;
+    return f_open(corpus, kCorpusPath, FA_READ) == FR_OK;
+  }
+
+  /// Reads the next `<label> <path>` entry of the corpus.
+  ///
+  /// @param corpus The open corpus.
+  /// @param line Set to the entry's line, terminated after the label.
+  /// @param path Set to the entry's path, within the line.
+  /// @returns False at the end of the corpus.
+  template <size_t kLength>
+  static bool ReadEntry(FIL * corpus, char (&line)[kLength], const char ** path)
+  {
+    while (true)
+    {
+      {
+        FileSystemLock lock;
+        if (f_gets(line, kLength, corpus) == nullptr)
+        {
+          return false;
+        }
+      }
+      line[std::strcspn(line, "\r\n")] = '\0';
+      char * separator = std::strchr(line, ' ');
+      if (line[0] == '\0' || line[0] == '#' || separator == nullptr)
+      {
+        continue;
+      }
+      *separator++ = '\0';
+      *path        = separator + std::strspn(separator, " \t");
+      return true;
+    }
+  }
+
+  void RunFile(const char * label, const char * path)
+  {
+    FILINFO info;
+    FRESULT result;
+    {
+      FileSystemLock lock;
+      result = f_stat(path, &info);
+    }
+    if (result != FR_OK)
+    {
+      std::printf(
+          "{\"label\":\"%s\",\"file\":\"%s\",\"status\":\"not found\"}\n",
+          label,
+          path);
+      return;
+    }
+
+    decoder_task_.ResetStatistics();
+    const uint32_t kStartUnderruns = decoder_task_.GetUnderrunCount();
+    const auto kStartTime          = sjsu::Uptime();
+
+    const mp3::SongHandle_t kSong = player_.AddSongPath(path);
+    player_.QueueSong(kSong, portMAX_DELAY);
+
+    const auto & statistics = decoder_task_.GetStatistics();
+    uint64_t last_bytes     = 0;
+    auto last_progress_time = kStartTime;
+    bool is_stalled         = false;
+    while (statistics.songs_completed == 0)
+    {
+      vTaskDelay(kPollPeriod);
+      if (statistics.bytes_buffered != last_bytes)
+      {
+        last_bytes         = statistics.bytes_buffered;
+        last_progress_time = sjsu::Uptime();
+      }
+      else if (sjsu::Uptime() - last_progress_time > kStallTimeout)
+      {
+        is_stalled = true;
+        break;
+      }
+    }
+
+    const auto kElapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+        sjsu::Uptime() - kStartTime);
+    const uint32_t kBytesPerSecond =
+        (kElapsed.count() > 0)
+            ? static_cast<uint32_t>((statistics.bytes_buffered * 1'000'000) /
+                                    kElapsed.count())
+            : 0;
+
+    const auto & read_statistics       = buffer_task_.GetSongStatistics();
+    const uint32_t kReadBytesPerSecond = read_statistics.GetBytesPerSecond();
+    const int32_t kReadHeadroomPercent =
+        (kBytesPerSecond > 0)
+            ? static_cast<int32_t>(
+                  (uint64_t{ kReadBytesPerSecond } * 100) / kBytesPerSecond) -
+                  100
+            : 0;
+
+    std::printf(
+        "{\"label\":\"%s\",\"file\":\"%s\",\"status\":\"%s\","
+        "\"size\":%lu,\"bytes\":%llu,\"elapsed_ms\":%llu,"
+        "\"bytes_per_second\":%lu,\"read_bytes_per_second\":%lu,"
+        "\"read_headroom_percent\":%ld,\"max_read_latency_us\":%llu,"
+        "\"reads\":%lu,\"fragments\":%lu,"
+        "\"max_block_wait_us\":%llu,\"underruns\":%lu,"
+        "\"buffer_length\":%zu,\"pipeline_depth\":%zu,"
+        "\"refill_watermark\":%zu,\"sdi_clock_hz\":%lu}\n",
+        label,
+        path,
+        is_stalled ? "stalled" : "ok",
+        static_cast<unsigned long>(info.fsize),
+        static_cast<unsigned long long>(statistics.bytes_buffered),
+        static_cast<unsigned long long>(kElapsed.count() / 1000),
+        static_cast<unsigned long>(kBytesPerSecond),
+        static_cast<unsigned long>(kReadBytesPerSecond),
+        static_cast<long>(kReadHeadroomPercent),
+        static_cast<unsigned long long>(read_statistics.max_latency.count()),
+        static_cast<unsigned long>(read_statistics.read_count),
+        static_cast<unsigned long>(buffer_task_.GetSongFragmentCount()),
+        static_cast<unsigned long long>(statistics.max_block_wait.count()),
+        static_cast<unsigned long>(decoder_task_.GetUnderrunCount() -
+                                   kStartUnderruns),
+        Pipeline::kBlockLength,
+        player_.GetBlockPool().GetBlockCount(),
+        buffer_task_.GetRefillWatermark(),
+        static_cast<unsigned long>(
+            decoder_.GetSdiFrequency().to<uint32_t>()));
+  }
+
+  /// Plays a file in place of the file playing, and reports the time taken
+  /// for the file to reach the decoder.
+  void RunSkip(const char * label, const char * path)
+  {
+    const Mp3Player::Command_t kPlay = {
+      .type = Mp3Player::Command::kPlay,
+      .song = player_.AddSongPath(path),
+    };
+    const auto & telemetry = decoder_task_.GetTelemetry();
+    const auto kStartTime  = sjsu::Uptime();
+    const auto kStatus     = player_.SendCommand(kPlay);
+    bool is_started        = false;
+    while (kStatus == Mp3Player::CommandStatus::kDone &&
+           sjsu::Uptime() - kStartTime <= kStallTimeout)
+    {
+      is_started = telemetry.last_start_time >= kStartTime;
+      if (is_started)
+      {
+        break;
+      }
+      vTaskDelay(1);
+    }
+
+    const auto kLatency = std::chrono::duration_cast<std::chrono::microseconds>(
+        telemetry.last_start_time - kStartTime);
+    std::printf(
+        "{\"label\":\"%s\",\"file\":\"%s\",\"status\":\"%s\","
+        "\"skip_latency_us\":%lld}\n",
+        label,
+        path,
+        is_started ? "ok" : "stalled",
+        static_cast<long long>(is_started ? kLatency.count() : -1));
+
+    // Lets the file play, so the next file interrupts a song mid-stream.
+    vTaskDelay(kSkipInterval);
+  }
+
+  Mp3Player & player_;
+  const Vs1053b & decoder_;
+  const AudioDataBufferTask<Pipeline> & buffer_task_;
+  AudioDataDecodeTask<Pipeline> & decoder_task_;
+};
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "L3_Application/task_scheduler.hpp"
+
+#include "../utility/seek_index.hpp"
+
+/// Builds the seek tables requested by AudioDataBufferTask for songs without a
+/// table of contents, a few frames at a time, and sleeps while there is
+/// nothing to build.
+///
+/// Runs at idle priority, so the walk only uses time the playback pipeline
+/// leaves unused.
+class SeekIndexTask final : public sjsu::rtos::Task<512>
+{
+ public:
+  explicit SeekIndexTask(mp3::SeekIndex & seek_index)
+      : Task("SeekIndexTask", sjsu::rtos::Priority::kIdle),
+        seek_index_(seek_index)
+  {
+  }
+
+  bool Run() override
+  {
+    if (seek_index_.Update())
+    {
+      seek_index_.WaitForRequest();
+    }
+    return true;
+  }
+
+ private:
+  mp3::SeekIndex & seek_index_;
+};
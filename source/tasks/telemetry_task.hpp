@@ -0,0 +1,165 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+#include "L3_Application/task_scheduler.hpp"
+#include "utility/log.hpp"
+
+#include "../drivers/vs1053b.hpp"
+#include "../utility/histogram.hpp"
+#include "audio_data_buffer_task.hpp"
+
+/// Collects the telemetry maintained by the playback pipeline into a single
+/// snapshot, and optionally logs it periodically when added to the scheduler.
+///
+/// The counters themselves are updated in place by AudioDataBufferTask,
+/// AudioDataDecodeTask and Vs1053b as they run, so the pipeline pays a few
+/// increments and timer reads per 1 KB block. Only taking a snapshot walks the
+/// task list for stack usage.
+template <typename Pipeline>
+class TelemetryTask final : public sjsu::rtos::Task<1024>
+{
+ public:
+  /// Maximum number of tasks whose stack usage is tracked.
+  static constexpr size_t kMaxTasks = 8;
+
+  struct StackUsage_t
+  {
+    const char * name;
+    /// Fewest words of the task's stack that have remained unused.
+    uint32_t free_words;
+  };
+
+  struct Snapshot_t
+  {
+    LatencyHistogram<> sd_read_latency;
+    LatencyHistogram<> dreq_wait;
+    /// Most and fewest blocks queued for the decoder mid-song.
+    size_t queue_high_watermark;
+    size_t queue_low_watermark;
+    uint32_t blocks_dropped;
+    /// Times the decoder needed a block mid-song and none was queued.
+    uint32_t underruns;
+    /// Estimated times the decoder's stream buffer ran empty mid-song.
+    uint32_t fifo_empty_events;
+    std::array<StackUsage_t, kMaxTasks> stacks;
+    size_t task_count;
+  };
+
+  /// @param decoder The decoder driver.
+  /// @param buffer_task The task reading audio from the SD card.
+  /// @param decoder_task The task sending audio to the decoder.
+  /// @param log_period Interval between logs when the task is scheduled.
+  TelemetryTask(
+      const Vs1053b & decoder,
+      const AudioDataBufferTask<Pipeline> & buffer_task,
+      const AudioDataDecodeTask<Pipeline> & decoder_task,
+      TickType_t log_period = pdMS_TO_TICKS(10'000))
+      : Task("TelemetryTask", sjsu::rtos::Priority::kLow),
+        decoder_(decoder),
+        buffer_task_(buffer_task),
+        decoder_task_(decoder_task),
+        kLogPeriod(log_period)
+  {
+  }
+
+  /// Adds a task whose stack high watermark is reported.
+  void TrackStack(const sjsu::rtos::TaskInterface & task)
+  {
+    if (task_count_ < kMaxTasks)
+    {
+      tasks_[task_count_++] = &task;
+    }
+  }
+
+  /// @returns The current value of every counter.
+  Snapshot_t GetSnapshot() const
+  {
+    const auto & buffer_telemetry  = buffer_task_.GetTelemetry();
+    const auto & decoder_telemetry = decoder_task_.GetTelemetry();
+    const auto & device_telemetry  = decoder_.GetTelemetry();
+
+    Snapshot_t snapshot = {
+      .sd_read_latency      = buffer_telemetry.read_latency,
+      .dreq_wait            = device_telemetry.dreq_wait,
+      .queue_high_watermark = decoder_telemetry.queue_high_watermark,
+      .queue_low_watermark  = decoder_telemetry.queue_low_watermark,
+      .blocks_dropped       = buffer_telemetry.blocks_dropped,
+      .underruns            = decoder_task_.GetUnderrunCount(),
+      .fifo_empty_events    = device_telemetry.fifo_empty_events,
+      .stacks               = {},
+      .task_count           = task_count_,
+    };
+
+    for (size_t i = 0; i < task_count_; i++)
+    {
+      const TaskHandle_t kHandle = tasks_[i]->GetHandle();
+      snapshot.stacks[i]         = StackUsage_t{
+        .name       = tasks_[i]->GetName(),
+        .free_words = (kHandle != nullptr)
+                          ? static_cast<uint32_t>(
+                                uxTaskGetStackHighWaterMark(kHandle))
+                          : 0,
+      };
+    }
+    return snapshot;
+  }
+
+  bool Run() override
+  {
+    vTaskDelay(kLogPeriod);
+
+    const Snapshot_t kSnapshot = GetSnapshot();
+    LogHistogram("SD read", kSnapshot.sd_read_latency);
+    LogHistogram("DREQ wait", kSnapshot.dreq_wait);
+    sjsu::LogInfo("Queue %zu..%zu blocks, %lu dropped, %lu underruns, "
+                  "%lu FIFO empty",
+                  (kSnapshot.queue_low_watermark == SIZE_MAX)
+                      ? 0
+                      : kSnapshot.queue_low_watermark,
+                  kSnapshot.queue_high_watermark,
+                  kSnapshot.blocks_dropped,
+                  kSnapshot.underruns,
+                  kSnapshot.fifo_empty_events);
+    for (size_t i = 0; i < kSnapshot.task_count; i++)
+    {
+      sjsu::LogInfo("Stack %s: %lu words free",
+                    kSnapshot.stacks[i].name,
+                    kSnapshot.stacks[i].free_words);
+    }
+    return true;
+  }
+
+ private:
+  static void LogHistogram(const char * name,
+                           const LatencyHistogram<> & histogram)
+  {
+    // Each bucket is printed as its count, in increasing order of latency.
+    char buckets[LatencyHistogram<>::GetBucketCount() * 11] = "";
+    size_t length                                           = 0;
+    for (size_t i = 0; i < histogram.GetBucketCount(); i++)
+    {
+      const unsigned long kCount = histogram.GetBucket(i);
+      length += std::snprintf(
+          buckets + length, sizeof(buckets) - length, " %lu", kCount);
+    }
+    sjsu::LogInfo("%s: n=%lu avg=%lld us max=%lld us, buckets from <%lld us:%s",
+                  name,
+                  histogram.GetCount(),
+                  histogram.GetAverage().count(),
+                  histogram.GetMax().count(),
+                  LatencyHistogram<>::kFirstBucketLimit.count(),
+                  buckets);
+  }
+
+  const Vs1053b & decoder_;
+  const AudioDataBufferTask<Pipeline> & buffer_task_;
+  const AudioDataDecodeTask<Pipeline> & decoder_task_;
+  const TickType_t kLogPeriod;
+
+  std::array<const sjsu::rtos::TaskInterface *, kMaxTasks> tasks_ = {};
+  size_t task_count_                                               = 0;
+};
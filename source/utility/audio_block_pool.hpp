@@ -0,0 +1,184 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "L3_Application/task_scheduler.hpp"
+
+#include "song_handle.hpp"
+#include "static_queue.hpp"
+
+/// A block of audio data owned by whichever task currently holds its handle.
+struct AudioBlock_t
+{
+  /// Pointer to the block's payload storage.
+  uint8_t * data;
+  /// Number of valid bytes in the payload.
+  size_t length;
+  /// True if this is the final block of a song.
+  bool is_last;
+  /// True if the decoder must be started before this block, since it is the
+  /// first block of the first song or of a song whose format differs from
+  /// the previous song's.
+  bool starts_stream;
+  /// True if the decoder must discard the audio it holds before this block,
+  /// since the block follows a seek.
+  bool cancels_stream;
+  /// Number of the song the block belongs to, counted from 1 by the producer
+  /// as it starts each song, so that two plays of the same file differ.
+  uint32_t song_number;
+  /// The song the block belongs to.
+  mp3::SongHandle_t song;
+  /// Generation of the song queue the song was queued under.
+  uint32_t generation;
+};
+
+/// A fixed pool of audio blocks. Tasks exchange `AudioBlock_t *` handles
+/// through FreeRTOS queues instead of copying the payloads, so each block is
+/// filled once by f_read and consumed in place by the decoder.
+class AudioBlockPool
+{
+ public:
+  /// Takes a free block from the pool.
+  ///
+  /// @param timeout Maximum number of ticks to wait for a block to be freed.
+  /// @returns Handle of the acquired block or nullptr if the timeout expired.
+  AudioBlock_t * Acquire(TickType_t timeout = portMAX_DELAY) const
+  {
+    AudioBlock_t * block = nullptr;
+    if (xQueueReceive(free_queue_, &block, timeout))
+    {
+      block->length         = 0;
+      block->is_last        = false;
+      block->starts_stream  = false;
+      block->cancels_stream = false;
+    }
+    return block;
+  }
+
+  /// Returns a block to the pool.
+  ///
+  /// @param block Handle of a block previously returned by Acquire().
+  void Release(AudioBlock_t * block) const
+  {
+    xQueueSend(free_queue_, &block, portMAX_DELAY);
+    if (free_threshold_ != 0 && GetFreeCount() >= free_threshold_)
+    {
+      xSemaphoreGive(free_semaphore_);
+    }
+  }
+
+  /// Blocks until at least a number of blocks are free. Lets a producer sleep
+  /// through a full pipeline and wake once to refill it in a burst, rather
+  /// than waking each time a single block is released.
+  ///
+  /// @note Only one task may wait at a time.
+  ///
+  /// @param count Number of free blocks to wait for.
+  /// @param timeout Maximum number of ticks to wait.
+  /// @returns True if the blocks are free or the wait was ended by Wake(),
+  ///          false if the timeout expired.
+  bool WaitForFree(size_t count, TickType_t timeout = portMAX_DELAY) const
+  {
+    free_threshold_ = count;
+    // Clear a give left over from a previous wait that was satisfied without
+    // blocking.
+    xSemaphoreTake(free_semaphore_, 0);
+    const bool kIsFree = GetFreeCount() >= count ||
+                         xSemaphoreTake(free_semaphore_, timeout);
+    free_threshold_ = 0;
+    return kIsFree;
+  }
+
+  /// Ends a wait in WaitForFree() early, so that the waiting producer can act
+  /// on a request such as a seek without waiting for the decoder.
+  void Wake() const
+  {
+    xSemaphoreGive(free_semaphore_);
+  }
+
+  /// @returns The capacity of each block in bytes.
+  size_t GetBlockLength() const
+  {
+    return block_length_;
+  }
+
+  /// @returns The total number of blocks in the pool.
+  size_t GetBlockCount() const
+  {
+    return block_count_;
+  }
+
+  /// @returns The number of blocks currently available.
+  size_t GetFreeCount() const
+  {
+    return uxQueueMessagesWaiting(free_queue_);
+  }
+
+ protected:
+  AudioBlockPool(size_t block_length, size_t block_count)
+      : block_length_(block_length), block_count_(block_count)
+  {
+    free_semaphore_ = xSemaphoreCreateBinaryStatic(&free_semaphore_buffer_);
+  }
+
+  /// Sets the queue of free blocks, which must have room for every block,
+  /// only used during construction before blocks are added.
+  void SetFreeQueue(QueueHandle_t free_queue)
+  {
+    free_queue_ = free_queue;
+  }
+
+  /// Adds a block to the free list, only used during construction.
+  void Add(AudioBlock_t * block) const
+  {
+    xQueueSend(free_queue_, &block, 0);
+  }
+
+ private:
+  const size_t block_length_;
+  const size_t block_count_;
+  QueueHandle_t free_queue_ = nullptr;
+  StaticSemaphore_t free_semaphore_buffer_;
+  SemaphoreHandle_t free_semaphore_;
+  mutable std::atomic<size_t> free_threshold_ = 0;
+};
+
+/// The payloads of the blocks of a StaticAudioBlockPool.
+template <size_t kBlockLength, size_t kBlockCount>
+using AudioBlockStorage =
+    std::array<std::array<uint8_t, kBlockLength>, kBlockCount>;
+
+/// An AudioBlockPool whose blocks and free list are held by the object, so
+/// that the pool takes nothing from the heap.
+///
+/// The payloads are held apart from the pool, so that they can be placed in
+/// a RAM bank the DMA controller can read.
+///
+/// @tparam kBlockLength The capacity of each block in bytes.
+/// @tparam kBlockCount  The number of blocks in the pool.
+template <size_t kBlockLength, size_t kBlockCount>
+class StaticAudioBlockPool final : public AudioBlockPool
+{
+ public:
+  /// @param storage The payloads of the blocks, used only by this pool.
+  explicit StaticAudioBlockPool(
+      AudioBlockStorage<kBlockLength, kBlockCount> & storage)
+      : AudioBlockPool(kBlockLength, kBlockCount)
+  {
+    SetFreeQueue(free_queue_.GetHandle());
+    for (size_t i = 0; i < kBlockCount; i++)
+    {
+      blocks_[i] = AudioBlock_t{
+        .data = storage[i].data(), .length = 0, .is_last = false
+      };
+      Add(&blocks_[i]);
+    }
+  }
+
+ private:
+  std::array<AudioBlock_t, kBlockCount> blocks_;
+  StaticQueue<AudioBlock_t *, kBlockCount> free_queue_;
+};
@@ -0,0 +1,296 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include "L3_Application/fatfs.hpp"
+#include "utility/log.hpp"
+#include "utility/time.hpp"
+
+#include "file_system_lock.hpp"
+
+/// A sequential reader that keeps a single FatFs file handle open for the
+/// lifetime of a song.
+///
+/// Keeping the handle open allows FatFs to follow the cluster chain
+/// incrementally instead of re-walking it from the start of the file on every
+/// f_lseek, so the cost of each read is independent of the file offset.
+///
+/// When FatFs is built with FF_USE_FASTSEEK, a cluster link map table (CLMT)
+/// of the file's fragments is built on open. Seeks and cluster boundaries are
+/// then resolved from the table in RAM instead of reading the FAT, which
+/// matters most for fragmented files. Files with more than kMaxFragments
+/// fragments fall back to the cluster chain.
+///
+/// Reads are shortened to end on a sector boundary. Once aligned, FatFs reads
+/// whole sectors straight into the caller's buffer with a single multi-sector
+/// disk read, rather than staging the partial sectors at either end through
+/// the file's sector buffer one sector at a time.
+///
+/// Every FatFs call is made while holding the FileSystemLock.
+class FileReader
+{
+ public:
+  static constexpr size_t kSectorSize = FF_MAX_SS;
+  /// Number of fragments the cluster link map table can hold, each takes 2
+  /// words of the table.
+  static constexpr size_t kMaxFragments = 63;
+
+  /// Throughput and latency statistics of the reads performed since the last
+  /// call to ResetStatistics().
+  struct Statistics_t
+  {
+    /// Total number of bytes read.
+    uint64_t bytes_read = 0;
+    /// Number of f_read calls performed.
+    uint32_t read_count = 0;
+    /// Accumulated time spent in f_read.
+    std::chrono::microseconds total_latency = 0us;
+    /// Shortest f_read call.
+    std::chrono::microseconds min_latency = std::chrono::microseconds::max();
+    /// Longest f_read call.
+    std::chrono::microseconds max_latency = 0us;
+
+    /// @returns The average read throughput in bytes per second.
+    uint32_t GetBytesPerSecond() const
+    {
+      if (total_latency.count() == 0)
+      {
+        return 0;
+      }
+      return static_cast<uint32_t>((bytes_read * 1'000'000) /
+                                   total_latency.count());
+    }
+
+    /// Accumulates the statistics of another interval into this one.
+    void Add(const Statistics_t & other)
+    {
+      bytes_read += other.bytes_read;
+      read_count += other.read_count;
+      total_latency += other.total_latency;
+      min_latency = std::min(min_latency, other.min_latency);
+      max_latency = std::max(max_latency, other.max_latency);
+    }
+
+    /// @returns The average latency of a single read.
+    std::chrono::microseconds GetAverageLatency() const
+    {
+      if (read_count == 0)
+      {
+        return 0us;
+      }
+      return total_latency / read_count;
+    }
+  };
+
+  FileReader() = default;
+  FileReader(const FileReader &) = delete;
+  FileReader & operator=(const FileReader &) = delete;
+
+  ~FileReader()
+  {
+    Close();
+  }
+
+  /// Opens a file for sequential reading. Any file that is currently open is
+  /// closed first.
+  ///
+  /// @param file_path Path of the file to open.
+  /// @returns True if the file was successfully opened.
+  bool Open(const char * file_path)
+  {
+    Close();
+    FileSystemLock lock;
+    is_open_        = (f_open(&file_, file_path, FA_READ) == FR_OK);
+    end_            = is_open_ ? f_size(&file_) : 0;
+    fragment_count_ = 0;
+#if FF_USE_FASTSEEK
+    if (is_open_)
+    {
+      CreateLinkMap();
+    }
+#endif
+    return is_open_;
+  }
+
+  /// Limits reading to a range of the opened file and moves to its start.
+  ///
+  /// @param start Offset of the first byte to read.
+  /// @param end Offset past the last byte to read.
+  /// @returns True if the range is within the file and the seek succeeded.
+  bool SetRange(size_t start, size_t end)
+  {
+    if (!is_open_ || start > end || end > f_size(&file_))
+    {
+      return false;
+    }
+
+    FileSystemLock lock;
+    if (f_lseek(&file_, start) != FR_OK)
+    {
+      return false;
+    }
+    end_ = end;
+    return true;
+  }
+
+  /// Moves to an offset within the range of the opened file.
+  ///
+  /// @param offset Offset of the next byte to read, clamped to the range.
+  /// @returns True if the seek succeeded.
+  bool Seek(size_t offset)
+  {
+    if (!is_open_)
+    {
+      return false;
+    }
+
+    FileSystemLock lock;
+    return f_lseek(&file_, std::min(offset, end_)) == FR_OK;
+  }
+
+  /// Closes the currently opened file, if any.
+  void Close()
+  {
+    if (is_open_)
+    {
+      FileSystemLock lock;
+      f_close(&file_);
+      is_open_ = false;
+    }
+  }
+
+  /// @returns True if a file is currently open.
+  bool IsOpen() const
+  {
+    return is_open_;
+  }
+
+  /// @returns True if all bytes of the file, or of its range, have been read.
+  bool IsEndOfFile() const
+  {
+    return !is_open_ || f_tell(&file_) >= end_;
+  }
+
+  /// @returns The size of the opened file in bytes.
+  size_t GetSize() const
+  {
+    return is_open_ ? f_size(&file_) : 0;
+  }
+
+  /// @returns The current read offset in bytes.
+  size_t GetPosition() const
+  {
+    return is_open_ ? f_tell(&file_) : 0;
+  }
+
+  /// @returns The number of fragments of the last file opened, or 0 if its
+  ///          cluster link map table could not be built.
+  uint32_t GetFragmentCount() const
+  {
+    return fragment_count_;
+  }
+
+  /// Reads the next chunk of the file, or of its range. Reads longer than a
+  /// sector are shortened by up to a sector to end on a sector boundary, and
+  /// the last read may return fewer bytes than requested.
+  ///
+  /// @param buffer Destination buffer.
+  /// @param length Maximum number of bytes to read.
+  /// @returns The number of bytes read, 0 once the end of the file is reached
+  ///          or if an error occurred.
+  size_t Read(uint8_t * buffer, size_t length)
+  {
+    if (!is_open_)
+    {
+      return 0;
+    }
+
+    // Stop at the end of the range.
+    const size_t kPosition = f_tell(&file_);
+    length = (kPosition < end_) ? std::min(length, end_ - kPosition) : 0;
+    // The end of the range needs no alignment, it is the last read.
+    const size_t kOverhang = (kPosition + length) % kSectorSize;
+    if (length > kSectorSize && kPosition + length < end_)
+    {
+      length -= kOverhang;
+    }
+
+    FileSystemLock lock;
+    UINT bytes_read = 0;
+    const auto kStartTime = sjsu::Uptime();
+    if (f_read(&file_, buffer, length, &bytes_read) != FR_OK)
+    {
+      return 0;
+    }
+    const auto kLatency =
+        std::chrono::duration_cast<std::chrono::microseconds>(sjsu::Uptime() -
+                                                              kStartTime);
+
+    statistics_.bytes_read += bytes_read;
+    statistics_.read_count++;
+    statistics_.total_latency += kLatency;
+    statistics_.min_latency = std::min(statistics_.min_latency, kLatency);
+    statistics_.max_latency = std::max(statistics_.max_latency, kLatency);
+    last_latency_           = kLatency;
+
+    return bytes_read;
+  }
+
+  /// @returns The latency of the most recent successful read.
+  std::chrono::microseconds GetLastLatency() const
+  {
+    return last_latency_;
+  }
+
+  /// @returns The statistics collected since the last reset.
+  const Statistics_t & GetStatistics() const
+  {
+    return statistics_;
+  }
+
+  /// Clears the collected statistics.
+  void ResetStatistics()
+  {
+    statistics_ = Statistics_t{};
+  }
+
+ private:
+#if FF_USE_FASTSEEK
+  /// Builds the cluster link map table of the opened file. The caller must
+  /// hold the FileSystemLock.
+  void CreateLinkMap()
+  {
+    file_.cltbl  = link_map_.data();
+    link_map_[0] = link_map_.size();
+
+    const FRESULT kResult = f_lseek(&file_, CREATE_LINKMAP);
+    // The first word is set to the number of words the table needs, 2 per
+    // fragment and 2 for the size and terminator.
+    const uint32_t kFragments = static_cast<uint32_t>(link_map_[0] / 2 - 1);
+    if (kResult == FR_OK)
+    {
+      fragment_count_ = kFragments;
+      return;
+    }
+    file_.cltbl = nullptr;
+    if (kResult == FR_NOT_ENOUGH_CORE)
+    {
+      sjsu::LogDebug("%lu fragments do not fit the link map", kFragments);
+    }
+  }
+
+  std::array<DWORD, 2 * kMaxFragments + 2> link_map_;
+#endif
+
+  FIL file_;
+  bool is_open_ = false;
+  /// Offset past the last byte to read.
+  size_t end_              = 0;
+  uint32_t fragment_count_ = 0;
+  Statistics_t statistics_;
+  std::chrono::microseconds last_latency_ = 0us;
+};
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "L3_Application/task_scheduler.hpp"
+
+/// Scoped lock serializing FatFs calls between tasks.
+///
+/// FatFs is built without FF_FS_REENTRANT, so the sector window shared by every
+/// open file and directory must not be used by two tasks at once. Each task
+/// that touches the file system while the scheduler is running holds this lock
+/// for the duration of its FatFs calls, and keeps it short so that
+/// AudioDataBufferTask is never held up for long.
+class FileSystemLock
+{
+ public:
+  FileSystemLock()
+  {
+    xSemaphoreTake(GetMutex(), portMAX_DELAY);
+  }
+
+  ~FileSystemLock()
+  {
+    xSemaphoreGive(GetMutex());
+  }
+
+  FileSystemLock(const FileSystemLock &) = delete;
+  FileSystemLock & operator=(const FileSystemLock &) = delete;
+
+ private:
+  static SemaphoreHandle_t GetMutex()
+  {
+    static StaticSemaphore_t mutex_buffer;
+    static SemaphoreHandle_t mutex = xSemaphoreCreateMutexStatic(&mutex_buffer);
+    return mutex;
+  }
+};
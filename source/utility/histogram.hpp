@@ -0,0 +1,81 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+/// A fixed-bucket latency histogram with power of two bucket bounds.
+///
+/// Bucket 0 counts samples below kFirstBucketLimit, and each following bucket
+/// covers twice the range of the one before it. The last bucket also counts
+/// every sample beyond its range. Recording a sample is a shift and a count
+/// leading zeros, cheap enough to run on every SD read and DREQ wait.
+///
+/// @tparam kBucketCount Number of buckets.
+template <size_t kBucketCount = 12>
+class LatencyHistogram
+{
+ public:
+  /// Upper bound of the first bucket.
+  static constexpr std::chrono::microseconds kFirstBucketLimit = 64us;
+
+  void Record(std::chrono::microseconds latency)
+  {
+    const uint32_t kValue = static_cast<uint32_t>(
+        std::max<int64_t>(latency.count(), 0) / kFirstBucketLimit.count());
+    // Bucket n holds values whose bit width is n.
+    const size_t kBucket =
+        (kValue == 0) ? 0 : static_cast<size_t>(32 - __builtin_clz(kValue));
+
+    buckets_[std::min(kBucket, kBucketCount - 1)]++;
+    count_++;
+    total_ += latency;
+    max_ = std::max(max_, latency);
+  }
+
+  void Reset()
+  {
+    *this = LatencyHistogram{};
+  }
+
+  /// @returns The number of samples in a bucket.
+  uint32_t GetBucket(size_t index) const
+  {
+    return buckets_[index];
+  }
+
+  /// @returns The exclusive upper bound of a bucket, the last bucket has no
+  ///          upper bound.
+  static constexpr std::chrono::microseconds GetBucketLimit(size_t index)
+  {
+    return kFirstBucketLimit * (1 << index);
+  }
+
+  static constexpr size_t GetBucketCount()
+  {
+    return kBucketCount;
+  }
+
+  uint32_t GetCount() const
+  {
+    return count_;
+  }
+
+  std::chrono::microseconds GetMax() const
+  {
+    return max_;
+  }
+
+  std::chrono::microseconds GetAverage() const
+  {
+    return (count_ == 0) ? 0us : total_ / count_;
+  }
+
+ private:
+  std::array<uint32_t, kBucketCount> buckets_ = {};
+  uint32_t count_                              = 0;
+  std::chrono::microseconds total_             = 0us;
+  std::chrono::microseconds max_               = 0us;
+};
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "utility/bit.hpp"
+
+namespace mp3
+{
+/// ID3v1 metadata of a MP3 file.
+///
+/// @see https://en.wikipedia.org/wiki/ID3
+struct Id3v1_t
+{
+  /// The ID3v1 tag size in bytes.
+  static constexpr size_t kSize = 128;
+
+  ///  3 bytes - should contain "TAG"
+  char header[3];
+  /// 30 bytes - 30 characters of title
+  char title[30];
+  /// 30 bytes - 30 characters of artist name
+  char artist[30];
+  /// 30 bytes - 30 characters of album name
+  char album[30];
+  ///  4 bytes - 4 digit year
+  char year[4];
+  /// 30 bytes - Comment
+  char comment[30];
+  ///  1 byte  - Index of the track's genre (0-255)
+  uint8_t genre;
+};
+static_assert(sizeof(Id3v1_t) == Id3v1_t::kSize,
+              "Id3v1_t must match the layout of the tag on disk.");
+
+/// @see https://id3.org/id3v2.3.0?highlight=(ID3%20tag%20version%202.3.0)
+/// @see https://id3.org/id3v2.4.0-structure?highlight=(id3v2.4.0-structure.txt)
+struct Id3v2
+{
+  /// Bit of TagHeader_t::flags set when the tag is unsynchronised.
+  static constexpr uint8_t kUnsynchronisationFlag = 1 << 7;
+  /// Bit of TagHeader_t::flags set when an extended header follows the header.
+  static constexpr uint8_t kExtendedHeaderFlag = 1 << 6;
+  /// Bit of TagHeader_t::flags set when a footer follows the tag (ID3v2.4).
+  static constexpr uint8_t kFooterFlag = 1 << 4;
+
+  /// @returns The formatted tag size in bytes.
+  ///
+  /// @note The size is synchsafe, each byte holds 7 bits of the size.
+  static uint32_t GetSize(const uint8_t size[4])
+  {
+    return sjsu::bit::Value()
+        .Insert(size[0], sjsu::bit::MaskFromRange(21, 27))
+        .Insert(size[1], sjsu::bit::MaskFromRange(14, 20))
+        .Insert(size[2], sjsu::bit::MaskFromRange(7, 13))
+        .Insert(size[3], sjsu::bit::MaskFromRange(0, 6));
+  }
+
+  struct TagHeader_t
+  {
+    /// The first 3 bytes should always be "ID3".
+    uint8_t identifier[3];
+    /// 2 byte version with high byte representing the major version and the low
+    /// byte the revision number.
+    ///
+    /// @note Major versions are not backwards compatible. Revision numbers are
+    ///       backwards compatible.
+    uint8_t major_version;
+    uint8_t revision_number;
+    uint8_t flags;
+    /// Size of the tag in bytes.
+    ///
+    /// @note The 7th bit for each byte is always cleared.
+    /// @note size[0] is the most significant byte.
+    uint8_t size[4];
+  };
+
+  struct FrameHeader_t
+  {
+    char identifier[4];
+    /// Size of the frame excluding its header. Synchsafe like the tag size in
+    /// ID3v2.4, a plain big endian integer in ID3v2.3.
+    uint8_t size[4];
+    uint8_t flags[2];
+  };
+
+  /// @param size The size field of a frame header.
+  /// @param major_version The major version of the tag.
+  /// @returns The size of a frame excluding its header, in bytes.
+  static uint32_t GetFrameSize(const uint8_t size[4], uint8_t major_version)
+  {
+    if (major_version >= 4)
+    {
+      return GetSize(size);
+    }
+    return (size[0] << 24) | (size[1] << 16) | (size[2] << 8) | size[3];
+  }
+};
+static_assert(sizeof(Id3v2::TagHeader_t) == 10);
+static_assert(sizeof(Id3v2::FrameHeader_t) == 10);
+}  // namespace mp3
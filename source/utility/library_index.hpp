@@ -0,0 +1,751 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include "L3_Application/fatfs.hpp"
+#include "utility/log.hpp"
+
+#include "file_system_lock.hpp"
+#include "metadata_parser.hpp"
+#include "mp3_frame.hpp"
+#include "song_handle.hpp"
+
+namespace mp3
+{
+/// A persistent index of the songs on the SD card, stored on the card itself
+/// so that the song list and each song's metadata are available at boot
+/// without scanning the directory or parsing any tags.
+///
+/// The index file is a header record followed by one fixed size record per
+/// song, so the Nth song is read with a single seek and a single sector read
+/// regardless of how many songs the card holds.
+///
+/// Songs are found by walking the root directory and its subdirectories, such
+/// as album folders, up to kMaxDepth levels deep, and are recorded by their
+/// absolute path.
+///
+/// After boot, Update() verifies the index against the directories a few songs
+/// at a time. A song whose name, size and modification time match its record
+/// is kept as is. Only songs that were added or changed are opened to parse
+/// their tags, and removed songs are dropped. When anything changed, the
+/// updated index is written to kRebuildPath and replaces the index once the
+/// whole tree has been verified, so the index being read stays intact until
+/// then.
+///
+/// The replaced index is kept as kPreviousPath until the next rebuild, so
+/// handles made before the rebuild still resolve to their songs, and Remap()
+/// finds those songs in the new index.
+class LibraryIndex
+{
+ public:
+  static constexpr const char * kIndexPath    = "/library.idx";
+  static constexpr const char * kRebuildPath  = "/library.tmp";
+  static constexpr const char * kPreviousPath = "/library.old";
+  /// Size of each record in bytes, one sector.
+  static constexpr size_t kRecordSize = 512;
+  /// Number of songs verified per call to Update().
+  static constexpr size_t kEntriesPerUpdate = 4;
+  /// Number of directory levels searched for songs, including the root.
+  static constexpr size_t kMaxDepth = 4;
+  /// Number of records searched ahead for a song before it is considered new.
+  /// Skipping over records drops the songs they belong to, which were removed
+  /// from the card.
+  static constexpr size_t kLookahead = 4;
+  /// Number of records searched on either side of a song's old position by
+  /// Remap().
+  static constexpr size_t kRemapDistance = 8 * kLookahead;
+
+  /// A song's record in the index.
+  struct Entry_t
+  {
+    /// Absolute path of the song.
+    char path[256];
+    /// Size of the file in bytes.
+    uint32_t file_size;
+    /// FAT modification date and time of the file, used along with its size
+    /// to detect changes.
+    uint16_t modified_date;
+    uint16_t modified_time;
+    /// The song's tags. When the tags do not give the duration, it is
+    /// estimated from the bitrate of the first frame, which is exact for
+    /// constant bitrate files.
+    Metadata_t metadata;
+    uint8_t reserved[36];
+  };
+  static_assert(sizeof(Entry_t) == kRecordSize,
+                "Entries must fill exactly one record.");
+
+  LibraryIndex() = default;
+  LibraryIndex(const LibraryIndex &) = delete;
+  LibraryIndex & operator=(const LibraryIndex &) = delete;
+
+  ~LibraryIndex()
+  {
+    Close();
+  }
+
+  /// Opens the index, creating an empty one if it does not exist or was
+  /// written by an incompatible version.
+  ///
+  /// @returns True if the index was opened.
+  bool Open()
+  {
+    Close();
+    FileSystemLock lock;
+    // The index is renamed to kPreviousPath before the rebuilt index takes its
+    // place. If power was lost in between, the previous index is restored.
+    if (f_stat(kIndexPath, &info_) == FR_NO_FILE)
+    {
+      f_rename(kPreviousPath, kIndexPath);
+    }
+    else
+    {
+      f_unlink(kPreviousPath);
+    }
+    if (f_open(&index_, kIndexPath, FA_READ | FA_WRITE | FA_OPEN_ALWAYS) !=
+        FR_OK)
+    {
+      return false;
+    }
+    is_open_ = true;
+
+    if (!ReadRecord(&index_, 0, &header_, sizeof(header_)) ||
+        std::memcmp(header_.magic, kMagic, sizeof(kMagic)) != 0 ||
+        header_.version != kVersion || header_.record_size != kRecordSize)
+    {
+      header_ = NewHeader(0);
+      WriteRecord(&index_, 0, &header_, sizeof(header_));
+      f_sync(&index_);
+    }
+    state_ = State::kIdle;
+    return true;
+  }
+
+  /// Closes the index, abandoning any verification in progress.
+  void Close()
+  {
+    if (!is_open_)
+    {
+      return;
+    }
+
+    FileSystemLock lock;
+    if (state_ == State::kScanning)
+    {
+      CloseDirectories();
+      if (output_ == &rebuild_)
+      {
+        f_close(&rebuild_);
+      }
+    }
+    f_close(&index_);
+    ClosePrevious();
+    is_open_ = false;
+    state_   = State::kIdle;
+  }
+
+  /// @returns Number of songs in the index.
+  size_t GetCount() const
+  {
+    return is_open_ ? header_.entry_count : 0;
+  }
+
+  /// Reads the record of a song.
+  ///
+  /// @param index Index of the song, less than GetCount().
+  /// @returns The record, valid until the next call to Read() or Update(), or
+  ///          nullptr if it could not be read.
+  const Entry_t * Read(size_t index)
+  {
+    if (index >= GetCount())
+    {
+      return nullptr;
+    }
+
+    FileSystemLock lock;
+    if (!ReadRecord(&index_, index + 1, &entry_, sizeof(entry_)))
+    {
+      return nullptr;
+    }
+    return &entry_;
+  }
+
+  /// @returns A handle to a song.
+  ///
+  /// @param index Index of the song, less than GetCount().
+  SongHandle_t GetHandle(size_t index) const
+  {
+    return SongHandle_t{
+      .source     = SongHandle_t::Source::kLibrary,
+      .reserved   = 0,
+      .generation = generation_,
+      .index      = static_cast<uint32_t>(index),
+    };
+  }
+
+  /// @returns Number of times the index has been replaced by a rebuild.
+  uint16_t GetGeneration() const
+  {
+    return generation_;
+  }
+
+  /// Reads the path of a song. Unlike the other methods, this may be called
+  /// from any task.
+  ///
+  /// @param song Handle made by GetHandle().
+  /// @param path Destination buffer.
+  /// @param length Size of the destination buffer.
+  /// @returns False if the song could not be read, or the index has been
+  ///          replaced more than once since the handle was made.
+  bool GetPath(const SongHandle_t & song, char * path, size_t length)
+  {
+    FileSystemLock lock;
+    FIL * records = GetRecords(song);
+    if (records == nullptr || length == 0)
+    {
+      return false;
+    }
+
+    const size_t kLength = std::min(length, sizeof(Entry_t::path));
+    if (!ReadRecord(records, song.index + 1, path, kLength))
+    {
+      return false;
+    }
+    path[kLength - 1] = '\0';
+    return true;
+  }
+
+  /// Reads the metadata of a song. Like GetPath(), this may be called from any
+  /// task.
+  ///
+  /// @param song Handle made by GetHandle().
+  /// @param metadata Set to the song's metadata.
+  /// @returns False if the song could not be read, or the index has been
+  ///          replaced more than once since the handle was made.
+  bool GetMetadata(const SongHandle_t & song, Metadata_t * metadata)
+  {
+    FileSystemLock lock;
+    FIL * records = GetRecords(song);
+    if (records == nullptr)
+    {
+      return false;
+    }
+
+    UINT count = 0;
+    return f_lseek(records,
+                   (song.index + 1) * kRecordSize +
+                       offsetof(Entry_t, metadata)) == FR_OK &&
+           f_read(records, metadata, sizeof(*metadata), &count) == FR_OK &&
+           count == sizeof(*metadata);
+  }
+
+  /// Finds the song of a handle made before the last rebuild in the rebuilt
+  /// index, so that songs queued before the rebuild can still be played in
+  /// order. Like Read(), this invalidates the record returned by Read().
+  ///
+  /// Records keep their order across a rebuild, so the song is searched for
+  /// up to kRemapDistance records away from its old position. The lock is
+  /// taken for each record read, so the other tasks are not held off the card
+  /// for the whole search.
+  ///
+  /// @param song Handle made by GetHandle(), set to the song's handle in the
+  ///             current index.
+  /// @returns False if the song was removed from the card, was moved further
+  ///          than kRemapDistance by the songs added or removed before it, or
+  ///          the handle could not be resolved.
+  bool Remap(SongHandle_t * song)
+  {
+    {
+      FileSystemLock lock;
+      FIL * records = GetRecords(*song);
+      if (records == &index_)
+      {
+        return true;
+      }
+      if (records == nullptr || !ReadRecord(records,
+                                            song->index + 1,
+                                            song_path_,
+                                            sizeof(song_path_)))
+      {
+        return false;
+      }
+      song_path_[sizeof(song_path_) - 1] = '\0';
+    }
+
+    const size_t kStart = song->index;
+    for (size_t distance = 0; distance <= kRemapDistance; distance++)
+    {
+      // Below the old position, then above it. Indices that wrap around are
+      // past the end and skipped.
+      const size_t kCandidates[] = { kStart - distance, kStart + distance };
+      for (size_t i = (distance == 0) ? 1 : 0; i < 2; i++)
+      {
+        const size_t kIndex = kCandidates[i];
+        FileSystemLock lock;
+        if (kIndex < GetCount() &&
+            ReadRecord(&index_, kIndex + 1, entry_.path, sizeof(entry_.path)) &&
+            std::strcmp(entry_.path, song_path_) == 0)
+        {
+          *song = GetHandle(kIndex);
+          return true;
+        }
+      }
+    }
+    return false;
+  }
+
+  /// @returns True once the index has been verified against the directories.
+  bool IsVerified() const
+  {
+    return state_ == State::kVerified;
+  }
+
+  /// Verifies the next kEntriesPerUpdate songs against the index.
+  ///
+  /// When the index starts out empty, each new song is appended to it right
+  /// away, so on the first boot songs become playable one Update() at a time.
+  ///
+  /// @returns True once the whole tree has been verified.
+  bool Update()
+  {
+    if (!is_open_ || state_ == State::kVerified)
+    {
+      return true;
+    }
+
+    if (state_ == State::kIdle)
+    {
+      FileSystemLock lock;
+      old_count_         = header_.entry_count;
+      read_position_     = 0;
+      write_position_    = 0;
+      output_            = (old_count_ == 0) ? &index_ : nullptr;
+      is_rebuild_failed_ = false;
+      directory_path_[0] = '\0';
+      depth_             = (f_opendir(&directories_[0], "") == FR_OK) ? 1 : 0;
+      state_             = State::kScanning;
+    }
+
+    for (size_t i = 0; i < kEntriesPerUpdate; i++)
+    {
+      FileSystemLock lock;
+      if (!FindNextSong())
+      {
+        Finish();
+        return true;
+      }
+      Verify(info_);
+      if (is_rebuild_failed_)
+      {
+        Finish();
+        return true;
+      }
+    }
+
+    if (output_ == &index_)
+    {
+      // Publish the songs appended so far.
+      FileSystemLock lock;
+      header_.entry_count = static_cast<uint32_t>(write_position_);
+      WriteRecord(&index_, 0, &header_, sizeof(header_));
+      f_sync(&index_);
+    }
+    return false;
+  }
+
+ private:
+  enum class State : uint8_t
+  {
+    kIdle,
+    kScanning,
+    kVerified,
+  };
+
+  struct Header_t
+  {
+    char magic[4];
+    uint16_t version;
+    uint16_t record_size;
+    uint32_t entry_count;
+  };
+
+  static constexpr char kMagic[4]   = { 'B', 'B', 'L', 'I' };
+  static constexpr uint16_t kVersion = 4;
+
+  static Header_t NewHeader(uint32_t entry_count)
+  {
+    Header_t header = {
+      .magic       = {},
+      .version     = kVersion,
+      .record_size = kRecordSize,
+      .entry_count = entry_count,
+    };
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    return header;
+  }
+
+  static bool ReadRecord(FIL * file, size_t record, void * data, size_t length)
+  {
+    UINT count = 0;
+    return f_lseek(file, record * kRecordSize) == FR_OK &&
+           f_read(file, data, length, &count) == FR_OK && count == length;
+  }
+
+  /// Renames the rebuilt index to the index. FatFs does not rename over an
+  /// existing file, so the index is first renamed to kPreviousPath, and is
+  /// renamed back if the rebuilt index cannot take its place.
+  ///
+  /// @returns True if the index was replaced.
+  static bool ReplaceIndex()
+  {
+    f_unlink(kPreviousPath);
+    if (f_rename(kIndexPath, kPreviousPath) != FR_OK)
+    {
+      return false;
+    }
+    if (f_rename(kRebuildPath, kIndexPath) != FR_OK)
+    {
+      f_rename(kPreviousPath, kIndexPath);
+      return false;
+    }
+    return true;
+  }
+
+  static bool WriteRecord(FIL * file,
+                          size_t record,
+                          const void * data,
+                          size_t length)
+  {
+    UINT count = 0;
+    return f_lseek(file, record * kRecordSize) == FR_OK &&
+           f_write(file, data, length, &count) == FR_OK && count == length;
+  }
+
+  /// @returns The index file holding the record of a song, which for a
+  ///          handle made before the last rebuild is the previous index, or
+  ///          nullptr if the handle does not resolve.
+  FIL * GetRecords(const SongHandle_t & song)
+  {
+    if (song.source != SongHandle_t::Source::kLibrary)
+    {
+      return nullptr;
+    }
+    if (song.generation == generation_ && song.index < GetCount())
+    {
+      return &index_;
+    }
+    if (is_previous_open_ &&
+        song.generation == static_cast<uint16_t>(generation_ - 1) &&
+        song.index < previous_count_)
+    {
+      return &previous_;
+    }
+    return nullptr;
+  }
+
+  void ClosePrevious()
+  {
+    if (is_previous_open_)
+    {
+      f_close(&previous_);
+      is_previous_open_ = false;
+    }
+  }
+
+  /// @returns True if the file name has a .mp3 extension, in any case.
+  static bool IsMp3(const char * name)
+  {
+    constexpr char kExtension[] = ".mp3";
+    const char * extension      = std::strrchr(name, '.');
+    if (extension == nullptr || std::strlen(extension) != 4)
+    {
+      return false;
+    }
+    for (size_t i = 1; i < 4; i++)
+    {
+      if (std::tolower(extension[i]) != kExtension[i])
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /// Advances the depth first walk of the directory tree to the next song.
+  /// Sets info_ to the song's directory entry and song_path_ to its path.
+  ///
+  /// @returns False once the whole tree has been walked.
+  bool FindNextSong()
+  {
+    while (depth_ > 0)
+    {
+      DIR & directory = directories_[depth_ - 1];
+      if (f_readdir(&directory, &info_) != FR_OK || info_.fname[0] == '\0')
+      {
+        // Leave the directory, trimming its name from the path.
+        f_closedir(&directory);
+        depth_--;
+        if (char * separator = std::strrchr(directory_path_, '/'))
+        {
+          *separator = '\0';
+        }
+        continue;
+      }
+      if (info_.fname[0] == '.' || (info_.fattrib & (AM_HID | AM_SYS)))
+      {
+        continue;
+      }
+
+      const size_t kLength = std::strlen(directory_path_);
+      if (kLength + 1 + std::strlen(info_.fname) >= sizeof(song_path_))
+      {
+        continue;
+      }
+      if (info_.fattrib & AM_DIR)
+      {
+        if (depth_ < kMaxDepth)
+        {
+          directory_path_[kLength] = '/';
+          std::strcpy(&directory_path_[kLength + 1], info_.fname);
+          if (f_opendir(&directories_[depth_], directory_path_) == FR_OK)
+          {
+            depth_++;
+          }
+          else
+          {
+            directory_path_[kLength] = '\0';
+          }
+        }
+        continue;
+      }
+      if (IsMp3(info_.fname))
+      {
+        std::snprintf(song_path_,
+                      sizeof(song_path_),
+                      "%s/%s",
+                      directory_path_,
+                      info_.fname);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void CloseDirectories()
+  {
+    for (; depth_ > 0; depth_--)
+    {
+      f_closedir(&directories_[depth_ - 1]);
+    }
+  }
+
+  /// Finds the song's record among the next kLookahead records of the index
+  /// and writes its record to the output.
+  void Verify(const FILINFO & info)
+  {
+    for (size_t i = 0; i < kLookahead && read_position_ + i < old_count_; i++)
+    {
+      if (!ReadRecord(&index_, read_position_ + i + 1, &entry_, sizeof(entry_)))
+      {
+        break;
+      }
+      if (std::strcmp(entry_.path, song_path_) != 0)
+      {
+        continue;
+      }
+
+      const bool kIsUnchanged = entry_.file_size == info.fsize &&
+                                entry_.modified_date == info.fdate &&
+                                entry_.modified_time == info.ftime;
+      if (i != 0 || !kIsUnchanged)
+      {
+        BeginRebuild();
+      }
+      read_position_ += i + 1;
+      if (!kIsUnchanged)
+      {
+        Build(info);
+      }
+      if (output_ != nullptr)
+      {
+        WriteRecord(output_, write_position_ + 1, &entry_, sizeof(entry_));
+      }
+      write_position_++;
+      return;
+    }
+
+    // The song was added since the index was written.
+    BeginRebuild();
+    Build(info);
+    if (output_ != nullptr)
+    {
+      WriteRecord(output_, write_position_ + 1, &entry_, sizeof(entry_));
+    }
+    write_position_++;
+  }
+
+  /// Starts writing the index to kRebuildPath, beginning with the records
+  /// verified so far.
+  void BeginRebuild()
+  {
+    if (output_ != nullptr)
+    {
+      return;
+    }
+
+    if (f_open(&rebuild_, kRebuildPath, FA_WRITE | FA_CREATE_ALWAYS) != FR_OK)
+    {
+      sjsu::LogError("Failed to create %s", kRebuildPath);
+      is_rebuild_failed_ = true;
+      return;
+    }
+    output_ = &rebuild_;
+
+    // Until now every song matched its record, so the records read so far are
+    // the ones to keep.
+    for (size_t i = 0; i < write_position_; i++)
+    {
+      ReadRecord(&index_, i + 1, &entry_, sizeof(entry_));
+      WriteRecord(&rebuild_, i + 1, &entry_, sizeof(entry_));
+    }
+  }
+
+  /// Fills entry_ with the song's size, tags and duration.
+  void Build(const FILINFO & info)
+  {
+    entry_ = Entry_t{};
+    std::strcpy(entry_.path, song_path_);
+    entry_.file_size     = static_cast<uint32_t>(info.fsize);
+    entry_.modified_date = info.fdate;
+    entry_.modified_time = info.ftime;
+
+    FIL file;
+    if (f_open(&file, song_path_, FA_READ) != FR_OK)
+    {
+      return;
+    }
+
+    Metadata_t & metadata = entry_.metadata;
+    parser_.Parse(&file, &metadata);
+
+    // Estimate the duration from the bitrate of the first frame.
+    FrameHeader_t frame;
+    UINT count = 0;
+    if (metadata.duration == 0 &&
+        f_lseek(&file, metadata.audio_start) == FR_OK &&
+        f_read(&file, scratch_.data(), scratch_.size(), &count) == FR_OK)
+    {
+      const size_t kOffset     = FindFrame(scratch_.data(), count, &frame);
+      const size_t kFirstFrame = metadata.audio_start + kOffset;
+      if (kOffset < count && kFirstFrame < metadata.audio_end)
+      {
+        const uint64_t kAudioBits =
+            uint64_t{ metadata.audio_end - kFirstFrame } * 8;
+        metadata.duration =
+            static_cast<uint32_t>((kAudioBits * 1000) / frame.bitrate);
+      }
+    }
+
+    f_close(&file);
+  }
+
+  /// Completes verification, replacing the index if it was rebuilt.
+  void Finish()
+  {
+    CloseDirectories();
+    state_ = State::kVerified;
+
+    if (is_rebuild_failed_)
+    {
+      // The records verified so far were not written anywhere, so the index
+      // is kept as it was until the next boot.
+      sjsu::LogError("Library index not updated");
+      return;
+    }
+
+    if (output_ == &rebuild_)
+    {
+      const Header_t kHeader =
+          NewHeader(static_cast<uint32_t>(write_position_));
+      const bool kIsWritten =
+          WriteRecord(&rebuild_, 0, &kHeader, sizeof(kHeader));
+      f_close(&rebuild_);
+      f_close(&index_);
+      ClosePrevious();
+      is_open_ = false;
+
+      if (kIsWritten && ReplaceIndex())
+      {
+        // Songs are renumbered, so handles made until now resolve through
+        // the previous index.
+        generation_++;
+        previous_count_   = old_count_;
+        is_previous_open_ =
+            f_open(&previous_, kPreviousPath, FA_READ) == FR_OK;
+      }
+      else
+      {
+        sjsu::LogError("Failed to replace %s", kIndexPath);
+        f_unlink(kRebuildPath);
+      }
+      if (f_open(&index_, kIndexPath, FA_READ | FA_WRITE) == FR_OK &&
+          ReadRecord(&index_, 0, &header_, sizeof(header_)))
+      {
+        is_open_ = true;
+      }
+    }
+    else if (header_.entry_count != write_position_)
+    {
+      // Either songs were appended to an empty index, or the songs at the end
+      // of the index were removed.
+      header_.entry_count = static_cast<uint32_t>(write_position_);
+      WriteRecord(&index_, 0, &header_, sizeof(header_));
+      f_sync(&index_);
+    }
+
+    sjsu::LogInfo("Library index verified, %lu songs", header_.entry_count);
+  }
+
+  FIL index_;
+  FIL rebuild_;
+  /// The index replaced by the last rebuild, see GetRecords().
+  FIL previous_;
+  bool is_open_          = false;
+  bool is_previous_open_ = false;
+  Header_t header_;
+  /// Number of songs in the previous index.
+  size_t previous_count_ = 0;
+  uint16_t generation_   = 0;
+  Entry_t entry_;
+  MetadataParser parser_;
+  std::array<uint8_t, 512> scratch_;
+
+  State state_ = State::kIdle;
+  /// Open directories from the root down to the one being walked.
+  std::array<DIR, kMaxDepth> directories_;
+  size_t depth_ = 0;
+  /// Path of the directory being walked, empty for the root.
+  char directory_path_[256] = "";
+  /// Path of the song being verified.
+  char song_path_[256] = "";
+  FILINFO info_;
+  /// Index of the file receiving verified records, nullptr while every song
+  /// has matched its record in place.
+  FIL * output_ = nullptr;
+  /// True if the index needed a rebuild but kRebuildPath could not be
+  /// created, which ends verification early.
+  bool is_rebuild_failed_ = false;
+  /// Number of records in the index when verification started.
+  size_t old_count_ = 0;
+  /// Next record of the index to verify.
+  size_t read_position_ = 0;
+  /// Number of records verified.
+  size_t write_position_ = 0;
+};
+}  // namespace mp3
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+#include "utility/log.hpp"
+
+/// A breakdown of the statically allocated RAM of the application by
+/// subsystem and RAM bank.
+///
+/// Every buffer, queue and task stack of the pipeline is held by a global
+/// object, so the sizes of those objects are known at compile time and sum to
+/// the RAM the application needs, with nothing taken from the heap while
+/// playing. The LPC17xx's SRAM is split into banks that no object can span,
+/// so each item is tagged with the bank it is placed in and each bank is
+/// checked against its size with a static_assert. The breakdown is logged at
+/// boot.
+///
+/// @tparam kBankCount Number of RAM banks.
+/// @tparam kCount Number of subsystems.
+template <size_t kBankCount, size_t kCount>
+class MemoryBudget
+{
+ public:
+  /// A bank of RAM.
+  struct Bank_t
+  {
+    const char * name;
+    size_t bytes;
+  };
+
+  /// The RAM used by a subsystem.
+  struct Item_t
+  {
+    const char * subsystem;
+    size_t bytes;
+    /// Index of the bank holding the subsystem's objects.
+    size_t bank;
+  };
+
+  /// @param banks The RAM banks and their sizes.
+  /// @param items The RAM used by each subsystem.
+  constexpr MemoryBudget(const std::array<Bank_t, kBankCount> & banks,
+                         const std::array<Item_t, kCount> & items)
+      : banks_(banks), items_(items)
+  {
+  }
+
+  /// @param bank Index of a bank.
+  /// @returns The bytes used by the subsystems placed in the bank.
+  constexpr size_t GetUsed(size_t bank) const
+  {
+    size_t used = 0;
+    for (const auto & item : items_)
+    {
+      if (item.bank == bank)
+      {
+        used += item.bytes;
+      }
+    }
+    return used;
+  }
+
+  /// @param bank Index of a bank.
+  /// @returns True if the subsystems placed in the bank fit in it.
+  constexpr bool IsWithinBudget(size_t bank) const
+  {
+    return bank < kBankCount && GetUsed(bank) <= banks_[bank].bytes;
+  }
+
+  /// Logs the bytes used by each subsystem, then the use and headroom of each
+  /// bank.
+  void Log() const
+  {
+    for (const auto & item : items_)
+    {
+      sjsu::LogInfo("RAM %-20s %-10s %6zu B",
+                    item.subsystem,
+                    banks_[item.bank].name,
+                    item.bytes);
+    }
+    for (size_t bank = 0; bank < kBankCount; bank++)
+    {
+      sjsu::LogInfo("RAM %-10s %zu of %zu B, %zu B free",
+                    banks_[bank].name,
+                    GetUsed(bank),
+                    banks_[bank].bytes,
+                    banks_[bank].bytes - GetUsed(bank));
+    }
+  }
+
+ private:
+  std::array<Bank_t, kBankCount> banks_;
+  std::array<Item_t, kCount> items_;
+};
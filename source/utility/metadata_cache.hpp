@@ -0,0 +1,100 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "L3_Application/task_scheduler.hpp"
+
+#include "metadata_parser.hpp"
+#include "song_handle.hpp"
+
+namespace mp3
+{
+/// A least recently used cache of song metadata, keyed by song handle.
+///
+/// Listing the same songs again, as when scrolling back and forth through the
+/// library, is served from RAM instead of the SD card. The cache holds at most
+/// kCapacity songs, and a lookup or insertion scans every slot, which for a
+/// handful of songs is cheaper than maintaining a list. Handles that no longer
+/// resolve, from a replaced index, are never looked up again and age out.
+///
+/// The cache may be used from any task.
+///
+/// @tparam kCapacity Number of songs held.
+template <size_t kCapacity>
+class MetadataCache
+{
+ public:
+  MetadataCache()
+  {
+    mutex_ = xSemaphoreCreateMutexStatic(&mutex_buffer_);
+  }
+
+  /// Copies the metadata of a song, if it is cached.
+  ///
+  /// @returns True if the song was cached.
+  bool Get(const SongHandle_t & song, Metadata_t * metadata)
+  {
+    xSemaphoreTake(mutex_, portMAX_DELAY);
+    Slot_t * slot = Find(song);
+    if (slot != nullptr)
+    {
+      slot->last_used = ++clock_;
+      *metadata       = slot->metadata;
+    }
+    xSemaphoreGive(mutex_);
+    return slot != nullptr;
+  }
+
+  /// Adds the metadata of a song, evicting the least recently used song if
+  /// the cache is full.
+  void Put(const SongHandle_t & song, const Metadata_t & metadata)
+  {
+    xSemaphoreTake(mutex_, portMAX_DELAY);
+    Slot_t * slot = Find(song);
+    if (slot == nullptr)
+    {
+      // Empty slots have never been used, so they are evicted first.
+      slot = &slots_[0];
+      for (auto & candidate : slots_)
+      {
+        if (candidate.last_used < slot->last_used)
+        {
+          slot = &candidate;
+        }
+      }
+      slot->song = song;
+    }
+    slot->last_used = ++clock_;
+    slot->metadata  = metadata;
+    xSemaphoreGive(mutex_);
+  }
+
+ private:
+  struct Slot_t
+  {
+    SongHandle_t song;
+    /// Value of clock_ when the slot was last used, 0 if it is empty.
+    uint32_t last_used = 0;
+    Metadata_t metadata;
+  };
+
+  Slot_t * Find(const SongHandle_t & song)
+  {
+    for (auto & slot : slots_)
+    {
+      if (slot.last_used != 0 && slot.song == song)
+      {
+        return &slot;
+      }
+    }
+    return nullptr;
+  }
+
+  std::array<Slot_t, kCapacity> slots_ = {};
+  uint32_t clock_                      = 0;
+  StaticSemaphore_t mutex_buffer_;
+  SemaphoreHandle_t mutex_;
+};
+}  // namespace mp3
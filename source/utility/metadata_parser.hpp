@@ -0,0 +1,329 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#include "L3_Application/fatfs.hpp"
+
+#include "id3.hpp"
+
+namespace mp3
+{
+/// The metadata of a song, as stored in the library index and the metadata
+/// cache.
+struct Metadata_t
+{
+  char title[64];
+  char artist[64];
+  char album[64];
+  /// Duration in milliseconds, 0 if unknown.
+  uint32_t duration;
+  /// File offset and size of the payload of the ID3v2 attached picture (APIC)
+  /// frame, 0 if there is none.
+  uint32_t picture_offset;
+  uint32_t picture_size;
+  /// Byte range of the file holding audio frames, between the ID3v2 tag at
+  /// the start of the file and the APE and ID3v1 tags at its end.
+  uint32_t audio_start;
+  uint32_t audio_end;
+};
+
+/// Reads the ID3v2 and ID3v1 tags of a MP3 file, and finds the range of the
+/// file holding audio frames.
+///
+/// ID3v2.3 and ID3v2.4 tags are walked one frame header at a time. Only the
+/// text frames of interest are read, through a fixed kWindowSize window, and
+/// every other frame is skipped with a seek, so large tags such as embedded
+/// cover art cost no more to parse than small ones. Fields missing from the
+/// ID3v2 tag are taken from the ID3v1 tag in the last 128 bytes of the file.
+///
+/// Text is converted to ASCII, other characters are replaced with '?'.
+///
+/// The audio range excludes the ID3v2 tag with its padding and footer, and
+/// the APEv2 and ID3v1 tags that may follow the audio, so that no tag bytes
+/// need to be sent to the decoder.
+///
+/// @see https://id3.org/id3v2.3.0
+/// @see https://id3.org/id3v2.4.0-structure
+/// @see https://id3.org/id3v2.4.0-frames
+/// @see https://wiki.hydrogenaud.io/index.php?title=APEv2_specification
+class MetadataParser
+{
+ public:
+  /// Maximum number of bytes read from a text frame, enough for a full
+  /// Metadata_t field encoded as UTF-16 with a byte order mark.
+  static constexpr size_t kWindowSize = 1 + 2 + 2 * 64;
+
+  /// Parses the tags of a file, the file position is left undefined.
+  ///
+  /// @param file An open file.
+  /// @param metadata Set to the parsed metadata, fields without a value are
+  ///                 left empty or 0.
+  void Parse(FIL * file, Metadata_t * metadata)
+  {
+    *metadata           = Metadata_t{};
+    metadata->audio_end = static_cast<uint32_t>(f_size(file));
+    ParseId3v2(file, metadata);
+    ParseId3v1(file, metadata);
+    SkipApeTag(file, metadata);
+  }
+
+ private:
+  bool ReadAt(FIL * file, uint32_t offset, void * data, size_t length)
+  {
+    UINT count = 0;
+    return f_lseek(file, offset) == FR_OK &&
+           f_read(file, data, length, &count) == FR_OK && count == length;
+  }
+
+  void ParseId3v2(FIL * file, Metadata_t * metadata)
+  {
+    Id3v2::TagHeader_t header;
+    if (!ReadAt(file, 0, &header, sizeof(header)) ||
+        std::memcmp(header.identifier, "ID3", 3) != 0)
+    {
+      return;
+    }
+
+    const uint32_t kTagEnd = sizeof(header) + Id3v2::GetSize(header.size);
+    metadata->audio_start  = kTagEnd;
+    if (header.flags & Id3v2::kFooterFlag)
+    {
+      metadata->audio_start += sizeof(header);
+    }
+
+    // Frames of unsynchronised tags would have to be decoded byte by byte,
+    // those tags are left to the ID3v1 fallback.
+    if ((header.major_version != 3 && header.major_version != 4) ||
+        (header.flags & Id3v2::kUnsynchronisationFlag))
+    {
+      return;
+    }
+
+    uint32_t position = sizeof(header);
+    if (header.flags & Id3v2::kExtendedHeaderFlag)
+    {
+      uint8_t size[4];
+      if (!ReadAt(file, position, size, sizeof(size)))
+      {
+        return;
+      }
+      // The ID3v2.4 size is synchsafe and includes itself, the ID3v2.3 size
+      // is a plain integer that excludes itself.
+      position += (header.major_version == 4)
+                      ? Id3v2::GetSize(size)
+                      : Id3v2::GetFrameSize(size, 3) + sizeof(size);
+    }
+
+    while (position + sizeof(Id3v2::FrameHeader_t) <= kTagEnd)
+    {
+      Id3v2::FrameHeader_t frame;
+      // The frames end where the padding begins.
+      if (!ReadAt(file, position, &frame, sizeof(frame)) ||
+          frame.identifier[0] == '\0')
+      {
+        break;
+      }
+
+      const uint32_t kDataOffset = position + sizeof(frame);
+      const uint32_t kSize =
+          Id3v2::GetFrameSize(frame.size, header.major_version);
+      if (kSize > kTagEnd - kDataOffset)
+      {
+        break;
+      }
+
+      if (IsFrame(frame, "TIT2"))
+      {
+        ReadText(file, kDataOffset, kSize, metadata->title);
+      }
+      else if (IsFrame(frame, "TPE1"))
+      {
+        ReadText(file, kDataOffset, kSize, metadata->artist);
+      }
+      else if (IsFrame(frame, "TALB"))
+      {
+        ReadText(file, kDataOffset, kSize, metadata->album);
+      }
+      else if (IsFrame(frame, "TLEN"))
+      {
+        char length[16] = "";
+        ReadText(file, kDataOffset, kSize, length);
+        metadata->duration =
+            static_cast<uint32_t>(std::strtoul(length, nullptr, 10));
+      }
+      else if (IsFrame(frame, "APIC"))
+      {
+        metadata->picture_offset = kDataOffset;
+        metadata->picture_size   = kSize;
+      }
+      position = kDataOffset + kSize;
+    }
+  }
+
+  void ParseId3v1(FIL * file, Metadata_t * metadata)
+  {
+    Id3v1_t tag;
+    const uint32_t kTagOffset = metadata->audio_end - Id3v1_t::kSize;
+    if (metadata->audio_end < metadata->audio_start + Id3v1_t::kSize ||
+        !ReadAt(file, kTagOffset, &tag, sizeof(tag)) ||
+        std::memcmp(tag.header, "TAG", 3) != 0)
+    {
+      return;
+    }
+
+    metadata->audio_end -= Id3v1_t::kSize;
+    CopyId3v1Field(metadata->title, tag.title);
+    CopyId3v1Field(metadata->artist, tag.artist);
+    CopyId3v1Field(metadata->album, tag.album);
+  }
+
+  /// Excludes an APEv2 tag, which precedes the ID3v1 tag when both are
+  /// present, from the audio range.
+  void SkipApeTag(FIL * file, Metadata_t * metadata)
+  {
+    // The footer of an APE tag, all integers are little endian.
+    struct ApeFooter_t
+    {
+      char preamble[8];
+      uint8_t version[4];
+      /// Size of the tag in bytes, including the footer but not the header.
+      uint8_t size[4];
+      uint8_t item_count[4];
+      uint8_t flags[4];
+      uint8_t reserved[8];
+    };
+    static_assert(sizeof(ApeFooter_t) == 32);
+    // Bit of the last flags byte set when the tag also has a header.
+    constexpr uint8_t kHasHeaderFlag = 1 << 7;
+
+    ApeFooter_t footer;
+    const uint32_t kFooterOffset = metadata->audio_end - sizeof(footer);
+    if (metadata->audio_end < metadata->audio_start + sizeof(footer) ||
+        !ReadAt(file, kFooterOffset, &footer, sizeof(footer)) ||
+        std::memcmp(footer.preamble, "APETAGEX", sizeof(footer.preamble)) != 0)
+    {
+      return;
+    }
+
+    uint32_t size = (footer.size[3] << 24) | (footer.size[2] << 16) |
+                    (footer.size[1] << 8) | footer.size[0];
+    if (footer.flags[3] & kHasHeaderFlag)
+    {
+      size += sizeof(footer);
+    }
+    if (size <= metadata->audio_end - metadata->audio_start)
+    {
+      metadata->audio_end -= size;
+    }
+  }
+
+  static bool IsFrame(const Id3v2::FrameHeader_t & frame, const char * id)
+  {
+    return std::memcmp(frame.identifier, id, sizeof(frame.identifier)) == 0;
+  }
+
+  /// Reads the start of a text frame into a field.
+  template <size_t kLength>
+  void ReadText(FIL * file,
+                uint32_t offset,
+                uint32_t size,
+                char (&text)[kLength])
+  {
+    const size_t kCount = std::min<size_t>(size, window_.size());
+    if (kCount == 0 || !ReadAt(file, offset, window_.data(), kCount))
+    {
+      return;
+    }
+    DecodeText(window_.data(), kCount, text, kLength);
+  }
+
+  /// Converts the payload of a text frame, an encoding byte followed by the
+  /// text, to a null terminated ASCII string.
+  static void DecodeText(const uint8_t * data,
+                         size_t length,
+                         char * text,
+                         size_t capacity)
+  {
+    enum Encoding : uint8_t
+    {
+      kIso88591 = 0,
+      kUtf16    = 1,
+      kUtf16Be  = 2,
+      kUtf8     = 3,
+    };
+
+    const uint8_t kEncoding = data[0];
+    data++;
+    length--;
+
+    size_t count = 0;
+    if (kEncoding == kUtf16 || kEncoding == kUtf16Be)
+    {
+      // UTF-16 text starts with a byte order mark, UTF-16BE text does not.
+      bool is_little_endian = false;
+      if (kEncoding == kUtf16 && length >= 2)
+      {
+        is_little_endian = (data[0] == 0xFF && data[1] == 0xFE);
+        data += 2;
+        length -= 2;
+      }
+      for (size_t i = 0; i + 1 < length && count + 1 < capacity; i += 2)
+      {
+        const uint16_t kCharacter = is_little_endian
+                                        ? (data[i + 1] << 8) | data[i]
+                                        : (data[i] << 8) | data[i + 1];
+        if (kCharacter == 0)
+        {
+          break;
+        }
+        text[count++] = (kCharacter < 0x80) ? static_cast<char>(kCharacter)
+                                            : '?';
+      }
+    }
+    else
+    {
+      for (size_t i = 0; i < length && count + 1 < capacity; i++)
+      {
+        if (data[i] == 0)
+        {
+          break;
+        }
+        // Skip UTF-8 continuation bytes, so each character becomes one '?'.
+        if (kEncoding == kUtf8 && (data[i] & 0xC0) == 0x80)
+        {
+          continue;
+        }
+        text[count++] = (data[i] < 0x80) ? static_cast<char>(data[i]) : '?';
+      }
+    }
+    text[count] = '\0';
+  }
+
+  /// Copies an ID3v1 field, which is padded with spaces or null characters,
+  /// if the field has no value yet.
+  template <size_t kDestinationLength, size_t kSourceLength>
+  static void CopyId3v1Field(char (&destination)[kDestinationLength],
+                             const char (&source)[kSourceLength])
+  {
+    static_assert(kDestinationLength > kSourceLength);
+    if (destination[0] != '\0')
+    {
+      return;
+    }
+    size_t length = strnlen(source, kSourceLength);
+    while (length > 0 && source[length - 1] == ' ')
+    {
+      length--;
+    }
+    std::memcpy(destination, source, length);
+    destination[length] = '\0';
+  }
+
+  std::array<uint8_t, kWindowSize> window_;
+};
+}  // namespace mp3
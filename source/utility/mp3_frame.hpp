@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+namespace mp3
+{
+/// The fields of a MPEG-1, MPEG-2 or MPEG-2.5 Layer III frame header.
+///
+/// @see http://www.mp3-tech.org/programmer/frame_header.html
+struct FrameHeader_t
+{
+  /// The frame header size in bytes.
+  static constexpr size_t kSize = 4;
+
+  /// Bitrate of the frame in bits per second.
+  uint32_t bitrate;
+  /// Sample rate in Hz.
+  uint32_t sample_rate;
+  /// Number of samples per channel encoded in the frame.
+  uint16_t samples_per_frame;
+  /// Length of the frame in bytes, including the header.
+  uint16_t length;
+  bool is_mpeg1;
+  bool is_mono;
+
+  /// Parses the frame header at the start of a buffer.
+  ///
+  /// @param data At least kSize bytes.
+  /// @returns The parsed header, or std::nullopt if data does not start with
+  ///          a valid Layer III frame header.
+  static std::optional<FrameHeader_t> Parse(const uint8_t * data)
+  {
+    // Layer III bitrates in kbps, indexed by [is MPEG-1][bitrate index].
+    static constexpr uint16_t kBitrates[2][16] = {
+      { 0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160, 0 },
+      { 0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 0 },
+    };
+    // Sample rates in Hz, indexed by [version][sample rate index].
+    static constexpr uint32_t kSampleRates[4][3] = {
+      { 11'025, 12'000, 8'000 },   // MPEG-2.5
+      { 0, 0, 0 },                 // Reserved
+      { 22'050, 24'000, 16'000 },  // MPEG-2
+      { 44'100, 48'000, 32'000 },  // MPEG-1
+    };
+
+    const uint32_t kHeader = (data[0] << 24) | (data[1] << 16) |
+                             (data[2] << 8) | data[3];
+    const uint32_t kSync            = kHeader >> 21;
+    const uint32_t kVersion         = (kHeader >> 19) & 0b11;
+    const uint32_t kLayer           = (kHeader >> 17) & 0b11;
+    const uint32_t kBitrateIndex    = (kHeader >> 12) & 0b1111;
+    const uint32_t kSampleRateIndex = (kHeader >> 10) & 0b11;
+    const uint32_t kPadding         = (kHeader >> 9) & 0b1;
+    const uint32_t kChannelMode     = (kHeader >> 6) & 0b11;
+
+    if (kSync != 0x7FF || kVersion == 0b01 || kLayer != 0b01 ||
+        kBitrateIndex == 0 || kBitrateIndex == 0b1111 ||
+        kSampleRateIndex == 0b11)
+    {
+      return std::nullopt;
+    }
+
+    FrameHeader_t header;
+    header.is_mpeg1          = (kVersion == 0b11);
+    header.is_mono           = (kChannelMode == 0b11);
+    header.bitrate           = kBitrates[header.is_mpeg1][kBitrateIndex] * 1000;
+    header.sample_rate       = kSampleRates[kVersion][kSampleRateIndex];
+    header.samples_per_frame = header.is_mpeg1 ? 1152 : 576;
+    header.length            = static_cast<uint16_t>(
+        (header.samples_per_frame / 8) * header.bitrate / header.sample_rate +
+        kPadding);
+    return header;
+  }
+};
+
+/// Searches a buffer for the first valid frame header.
+///
+/// @param data The buffer to search.
+/// @param length Number of bytes in the buffer.
+/// @param header Set to the header that was found.
+/// @returns The offset of the frame header in the buffer, or length if no
+///          frame header was found.
+inline size_t FindFrame(const uint8_t * data,
+                        size_t length,
+                        FrameHeader_t * header)
+{
+  for (size_t offset = 0; offset + FrameHeader_t::kSize <= length; offset++)
+  {
+    if (data[offset] != 0xFF)
+    {
+      continue;
+    }
+    if (auto parsed = FrameHeader_t::Parse(&data[offset]))
+    {
+      *header = *parsed;
+      return offset;
+    }
+  }
+  return length;
+}
+}  // namespace mp3
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include "utility/time.hpp"
+
+#include "audio_block_pool.hpp"
+#include "file_reader.hpp"
+
+/// The geometry of the audio pipeline: the blocks read by AudioDataBufferTask
+/// and decoded by AudioDataDecodeTask, the queue between them, and the stacks
+/// of the tasks. Every task of the pipeline is instantiated with the same
+/// configuration, and the configuration is checked at compile time, so that a
+/// product can trade RAM for latency without a block length that splits SDI
+/// bursts or sector reads.
+///
+/// The pipeline holds kBlockCount * kBlockLength bytes of audio. At 128 kbit/s
+/// the default 6 blocks of 1 KB ride out an SD card stall of about 380 ms.
+///
+/// @tparam kBlockLengthValue Capacity of each audio block in bytes.
+/// @tparam kBlockCountValue Number of blocks in the pool shared by the buffer
+///         and decode tasks. Deeper pipelines ride out longer SD card stalls
+///         at the cost of 1 block of RAM each.
+/// @tparam kRefillWatermarkValue Number of blocks still queued for the
+///         decoder when the buffer task wakes to refill the pipeline, until
+///         the bitrate of the song is known. Between refills the buffer task
+///         sleeps.
+template <size_t kBlockLengthValue,
+          size_t kBlockCountValue,
+          size_t kRefillWatermarkValue = kBlockCountValue / 2>
+struct PipelineConfig
+{
+  static constexpr size_t kBlockLength     = kBlockLengthValue;
+  static constexpr size_t kBlockCount      = kBlockCountValue;
+  static constexpr size_t kRefillWatermark = kRefillWatermarkValue;
+
+  /// The payloads of the pipeline's blocks, given to Mp3PlayerTask.
+  using BlockStorage = AudioBlockStorage<kBlockLength, kBlockCount>;
+
+  /// Number of bytes the decoder accepts each time DREQ is high, see
+  /// Vs1053b::kSdiChunkSize.
+  static constexpr size_t kSdiBurstLength = 32;
+  /// Reads of whole sectors go straight from the SD card into the block, see
+  /// FileReader.
+  static constexpr size_t kSectorSize = FileReader::kSectorSize;
+
+  /// Audio still queued for the decoder when the buffer task wakes to refill
+  /// the pipeline, enough to ride out an SD card stall. The refill watermark
+  /// follows the bitrate of the song, see GetRefillWatermark().
+  static constexpr std::chrono::milliseconds kReadAhead = 100ms;
+  /// Highest bitrate of a MP3 stream in bits per second.
+  static constexpr uint32_t kMaxBitrate = 320'000;
+
+  /// @param bitrate Bitrate of the song in bits per second.
+  /// @returns The number of queued blocks that hold kReadAhead of audio,
+  ///          leaving at least 1 block free.
+  static constexpr size_t GetRefillWatermark(uint32_t bitrate)
+  {
+    const uint64_t kBytes =
+        uint64_t{ bitrate } / 8 * kReadAhead.count() / 1000;
+    const size_t kBlocks =
+        static_cast<size_t>((kBytes + kBlockLength - 1) / kBlockLength);
+    if (kBlocks < 1)
+    {
+      return 1;
+    }
+    return (kBlocks < kBlockCount) ? kBlocks : kBlockCount - 1;
+  }
+
+  /// Stack sizes of the pipeline's tasks, as given to sjsu::rtos::Task.
+  static constexpr size_t kPlayerTaskStackSize = 1024;
+  static constexpr size_t kBufferTaskStackSize = 4 * 1024;
+  static constexpr size_t kDecodeTaskStackSize = 512;
+
+  static_assert(kBlockLength % kSdiBurstLength == 0,
+                "The block length must be a multiple of the SDI burst length, "
+                "so that no block ends in a partial burst.");
+  static_assert(kBlockLength % kSectorSize == 0,
+                "The block length must be a multiple of the sector size, so "
+                "that aligned reads span whole sectors.");
+  static_assert(kBlockCount >= 2,
+                "The pipeline needs at least 2 blocks to overlap reading "
+                "with decoding.");
+  static_assert(kRefillWatermark >= 1 && kRefillWatermark < kBlockCount,
+                "The refill watermark must leave at least 1 block queued and "
+                "at least 1 block free.");
+  static_assert((uint64_t{ kMaxBitrate } / 8 * kReadAhead.count() / 1000 +
+                 kBlockLength - 1) / kBlockLength < kBlockCount,
+                "The pipeline must hold kReadAhead of audio at the highest "
+                "bitrate, with at least 1 block free.");
+};
+
+/// The pipeline of the BlockBoombox board.
+using DefaultPipelineConfig = PipelineConfig<1024, 6>;
@@ -0,0 +1,434 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "L3_Application/fatfs.hpp"
+#include "L3_Application/task_scheduler.hpp"
+
+#include "file_system_lock.hpp"
+#include "mp3_frame.hpp"
+#include "seek_table.hpp"
+#include "song_handle.hpp"
+
+namespace mp3
+{
+/// Seek tables of recently played songs, and the builder that makes them.
+///
+/// The table of a song is taken from the table of contents in the Xing/Info or
+/// VBRI header of its first frame when it has one, which costs a single read.
+/// Otherwise the frame headers of the song are walked one after another, with
+/// an entry recorded about once a second. The walk reads kFramesPerUpdate
+/// headers per call to Update() and releases the file system in between, so it
+/// runs in the background without holding up AudioDataBufferTask.
+///
+/// Tables are kept for the last kCapacity songs requested, so seeking again in
+/// a song reads nothing but the audio. A table still being built can be used
+/// for the part of the song walked so far.
+///
+/// Get() and Request() may be called from any task, Update() from one task.
+///
+/// @see http://gabriel.mp3-tech.org/mp3infotag.html
+/// @see https://www.codeproject.com/Articles/8295/MPEG-Audio-Frame-Header
+class SeekIndex
+{
+ public:
+  /// Number of songs whose tables are kept.
+  static constexpr size_t kCapacity = 2;
+  /// Number of frame headers read per call to Update().
+  static constexpr size_t kFramesPerUpdate = 16;
+
+  SeekIndex()
+  {
+    mutex_   = xSemaphoreCreateMutexStatic(&mutex_buffer_);
+    request_ = xSemaphoreCreateBinaryStatic(&request_buffer_);
+  }
+
+  /// Copies the table of a song.
+  ///
+  /// @returns False if no table has been requested for the song, or it has
+  ///          since been evicted.
+  bool Get(const SongHandle_t & song, SeekTable * table)
+  {
+    xSemaphoreTake(mutex_, portMAX_DELAY);
+    Slot_t * slot = Find(song);
+    if (slot != nullptr)
+    {
+      slot->last_used = ++clock_;
+      *table          = slot->table;
+    }
+    xSemaphoreGive(mutex_);
+    return slot != nullptr;
+  }
+
+  /// Starts building the table of a song, in place of any table being built.
+  /// Does nothing if the song already has a table.
+  ///
+  /// @param song The song.
+  /// @param path Path of the song.
+  /// @param audio_start Offset of the first audio frame.
+  /// @param audio_end Offset past the last audio frame.
+  void Request(const SongHandle_t & song,
+               const char * path,
+               uint32_t audio_start,
+               uint32_t audio_end)
+  {
+    xSemaphoreTake(mutex_, portMAX_DELAY);
+    if (Find(song) == nullptr)
+    {
+      // Empty slots have never been used, so they are evicted first.
+      Slot_t * slot = &slots_[0];
+      for (auto & candidate : slots_)
+      {
+        if (candidate.last_used < slot->last_used)
+        {
+          slot = &candidate;
+        }
+      }
+      slot->song      = song;
+      slot->last_used = ++clock_;
+      slot->table     = SeekTable{};
+
+      pending_.song  = song;
+      pending_.start = audio_start;
+      pending_.end   = audio_end;
+      std::strncpy(pending_.path, path, sizeof(pending_.path) - 1);
+      pending_.path[sizeof(pending_.path) - 1] = '\0';
+      has_pending_                             = true;
+      xSemaphoreGive(request_);
+    }
+    xSemaphoreGive(mutex_);
+  }
+
+  /// Builds part of the requested table.
+  ///
+  /// @returns True once there is nothing left to build.
+  bool Update()
+  {
+    xSemaphoreTake(mutex_, portMAX_DELAY);
+    const bool kIsNewRequest = has_pending_;
+    if (kIsNewRequest)
+    {
+      build_       = pending_;
+      has_pending_ = false;
+    }
+    xSemaphoreGive(mutex_);
+
+    if (kIsNewRequest)
+    {
+      Start();
+    }
+    if (!is_building_)
+    {
+      return true;
+    }
+
+    std::array<uint32_t, kFramesPerUpdate> frames;
+    size_t count = 0;
+    {
+      FileSystemLock lock;
+      FrameHeader_t header;
+      while (count < frames.size() && FindNextFrame(&header))
+      {
+        frames[count++] = position_;
+        position_ += header.length;
+      }
+    }
+    const bool kIsDone = (count < frames.size());
+
+    xSemaphoreTake(mutex_, portMAX_DELAY);
+    Slot_t * slot = Find(build_.song);
+    if (slot != nullptr)
+    {
+      for (size_t i = 0; i < count; i++)
+      {
+        slot->table.AddFrame(frames[i]);
+      }
+      if (kIsDone)
+      {
+        slot->table.Finish();
+      }
+    }
+    xSemaphoreGive(mutex_);
+
+    if (kIsDone || slot == nullptr)
+    {
+      Stop();
+    }
+    return false;
+  }
+
+  /// Sleeps until a table is requested.
+  void WaitForRequest()
+  {
+    xSemaphoreTake(request_, portMAX_DELAY);
+  }
+
+ private:
+  struct Slot_t
+  {
+    SongHandle_t song;
+    /// Value of clock_ when the slot was last used, 0 if it is empty.
+    uint32_t last_used = 0;
+    SeekTable table;
+  };
+
+  struct Request_t
+  {
+    SongHandle_t song;
+    uint32_t start = 0;
+    uint32_t end   = 0;
+    char path[256] = "";
+  };
+
+  /// Enough to hold a frame header, side information and a Xing header with
+  /// its 100 byte table of contents.
+  static constexpr size_t kWindowSize = 192;
+
+  Slot_t * Find(const SongHandle_t & song)
+  {
+    for (auto & slot : slots_)
+    {
+      if (slot.last_used != 0 && slot.song == song)
+      {
+        return &slot;
+      }
+    }
+    return nullptr;
+  }
+
+  /// Opens the requested song and reads its first frame. The table is filled
+  /// from the song's table of contents if it has one, otherwise the frames are
+  /// walked by the following updates.
+  void Start()
+  {
+    Stop();
+
+    SeekTable table;
+    bool is_walking = false;
+    {
+      FileSystemLock lock;
+      if (f_open(&file_, build_.path, FA_READ) != FR_OK)
+      {
+        return;
+      }
+      is_building_ = true;
+      end_         = std::min<uint32_t>(build_.end, f_size(&file_));
+      position_    = build_.start;
+
+      FrameHeader_t header;
+      if (FindNextFrame(&header))
+      {
+        if (!ReadAt(position_, kWindowSize) ||
+            (!ReadXing(header, &table) && !ReadVbri(header, &table)))
+        {
+          // About one entry per second until the table fills up.
+          table.Reset(header, header.sample_rate / header.samples_per_frame);
+          is_walking = true;
+        }
+      }
+    }
+
+    xSemaphoreTake(mutex_, portMAX_DELAY);
+    Slot_t * slot = Find(build_.song);
+    if (slot != nullptr)
+    {
+      slot->table = table;
+    }
+    xSemaphoreGive(mutex_);
+
+    if (!is_walking)
+    {
+      Stop();
+    }
+  }
+
+  void Stop()
+  {
+    if (is_building_)
+    {
+      FileSystemLock lock;
+      f_close(&file_);
+      is_building_ = false;
+    }
+  }
+
+  /// Reads the header of the frame at position_, searching forward for the
+  /// next frame if the stream has lost sync. Must hold the FileSystemLock.
+  ///
+  /// @param header Set to the header of the frame.
+  /// @returns False at the end of the audio.
+  bool FindNextFrame(FrameHeader_t * header)
+  {
+    while (position_ + FrameHeader_t::kSize <= end_)
+    {
+      const size_t kLength = std::min<size_t>(kWindowSize, end_ - position_);
+      if (!ReadAt(position_, kLength))
+      {
+        return false;
+      }
+
+      const size_t kOffset = FindFrame(window_.data(), kLength, header);
+      if (kOffset < kLength)
+      {
+        position_ += static_cast<uint32_t>(kOffset);
+        return true;
+      }
+      // A header may straddle the end of the window.
+      position_ += static_cast<uint32_t>(kLength - FrameHeader_t::kSize + 1);
+    }
+    return false;
+  }
+
+  /// Takes the table from a Xing or Info header, held by window_ along with
+  /// the first frame.
+  bool ReadXing(const FrameHeader_t & header, SeekTable * table)
+  {
+    constexpr uint32_t kFramesFlag = 1 << 0;
+    constexpr uint32_t kBytesFlag  = 1 << 1;
+    constexpr uint32_t kTocFlag    = 1 << 2;
+    constexpr size_t kTocSize      = 100;
+
+    // The Xing header follows the side information of the frame.
+    const size_t kSideInfoSize = header.is_mpeg1 ? (header.is_mono ? 17 : 32)
+                                                 : (header.is_mono ? 9 : 17);
+    const uint8_t * tag = &window_[FrameHeader_t::kSize + kSideInfoSize];
+    if (std::memcmp(tag, "Xing", 4) != 0 && std::memcmp(tag, "Info", 4) != 0)
+    {
+      return false;
+    }
+
+    const uint32_t kFlags = ReadBigEndian(&tag[4], 4);
+    const uint8_t * field = &tag[8];
+    if (!(kFlags & kFramesFlag) || !(kFlags & kTocFlag))
+    {
+      return false;
+    }
+    const uint32_t kFrameCount = ReadBigEndian(field, 4);
+    field += 4;
+    uint32_t bytes = end_ - position_;
+    if (kFlags & kBytesFlag)
+    {
+      bytes = ReadBigEndian(field, 4);
+      field += 4;
+    }
+    const uint8_t * toc = field;
+    if (kFrameCount == 0)
+    {
+      return false;
+    }
+
+    const uint32_t kFramesPerEntry = std::max<uint32_t>(
+        (kFrameCount + SeekTable::kMaxEntries - 1) / SeekTable::kMaxEntries,
+        header.sample_rate / header.samples_per_frame);
+    table->Reset(header, kFramesPerEntry);
+    for (uint32_t frame = 0; frame < kFrameCount; frame += kFramesPerEntry)
+    {
+      // Entry i of the table of contents is the offset of i percent of the
+      // song in 1/256ths of its size, interpolate between the two entries
+      // around the frame.
+      const uint32_t kPercent = static_cast<uint32_t>(
+          uint64_t{ frame } * kTocSize * 256 / kFrameCount);
+      const size_t kIndex   = kPercent / 256;
+      const uint32_t kLower = toc[kIndex];
+      const uint32_t kUpper = std::max<uint32_t>(
+          (kIndex + 1 < kTocSize) ? toc[kIndex + 1] : 256, kLower);
+      const uint64_t kScaled =
+          kLower * 256 + (kUpper - kLower) * (kPercent % 256);
+      table->AddEntry(position_ +
+                      static_cast<uint32_t>(bytes * kScaled / 65536));
+    }
+    table->Finish();
+    return true;
+  }
+
+  /// Takes the table from a VBRI header, held by window_ along with the first
+  /// frame. Must hold the FileSystemLock.
+  bool ReadVbri(const FrameHeader_t & header, SeekTable * table)
+  {
+    // The VBRI header always follows 32 bytes of side information.
+    constexpr size_t kTagOffset = FrameHeader_t::kSize + 32;
+    constexpr size_t kTocOffset = kTagOffset + 26;
+    const uint8_t * tag         = &window_[kTagOffset];
+    if (std::memcmp(tag, "VBRI", 4) != 0)
+    {
+      return false;
+    }
+
+    const uint32_t kEntryCount     = ReadBigEndian(&tag[18], 2);
+    const uint32_t kScale          = ReadBigEndian(&tag[20], 2);
+    const uint32_t kEntrySize      = ReadBigEndian(&tag[22], 2);
+    const uint32_t kFramesPerEntry = ReadBigEndian(&tag[24], 2);
+    if (kEntryCount == 0 || kEntrySize == 0 || kEntrySize > 4 ||
+        kFramesPerEntry == 0)
+    {
+      return false;
+    }
+
+    // Merge entries so that the table fits without being coarsened.
+    const uint32_t kStride =
+        (kEntryCount + SeekTable::kMaxEntries - 1) / SeekTable::kMaxEntries;
+    table->Reset(header, kFramesPerEntry * kStride);
+
+    // Each entry holds the size of its part of the song, which starts after
+    // the VBRI frame.
+    const uint32_t kTocStart = position_ + kTocOffset;
+    uint32_t offset          = position_ + header.length;
+    for (uint32_t i = 0; i < kEntryCount && offset < end_; i++)
+    {
+      if (i % kStride == 0)
+      {
+        table->AddEntry(offset);
+      }
+      if (!ReadAt(kTocStart + i * kEntrySize, kEntrySize))
+      {
+        return false;
+      }
+      offset += ReadBigEndian(window_.data(), kEntrySize) * kScale;
+    }
+    table->Finish();
+    return true;
+  }
+
+  /// Reads part of the file into window_. Must hold the FileSystemLock.
+  bool ReadAt(uint32_t offset, size_t length)
+  {
+    UINT count = 0;
+    return f_lseek(&file_, offset) == FR_OK &&
+           f_read(&file_, window_.data(), length, &count) == FR_OK &&
+           count == length;
+  }
+
+  static uint32_t ReadBigEndian(const uint8_t * data, size_t length)
+  {
+    uint32_t value = 0;
+    for (size_t i = 0; i < length; i++)
+    {
+      value = (value << 8) | data[i];
+    }
+    return value;
+  }
+
+  std::array<Slot_t, kCapacity> slots_ = {};
+  uint32_t clock_                      = 0;
+  Request_t pending_;
+  bool has_pending_ = false;
+  StaticSemaphore_t mutex_buffer_;
+  SemaphoreHandle_t mutex_;
+  StaticSemaphore_t request_buffer_;
+  SemaphoreHandle_t request_;
+
+  // Owned by the task calling Update().
+  Request_t build_;
+  FIL file_;
+  bool is_building_ = false;
+  /// Offset of the next frame to walk.
+  uint32_t position_ = 0;
+  /// Offset past the last audio frame.
+  uint32_t end_ = 0;
+  std::array<uint8_t, kWindowSize> window_;
+};
+}  // namespace mp3
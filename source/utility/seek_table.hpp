@@ -0,0 +1,155 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+#include "utility/time.hpp"
+
+#include "mp3_frame.hpp"
+
+namespace mp3
+{
+/// File offsets of the frames of a song at a fixed interval of playback time.
+///
+/// Entry i holds the offset of frame i * frames_per_entry, so the playback
+/// time of every entry is known exactly from the duration of a frame. A seek
+/// reads from the entry at or before the requested time.
+///
+/// Once the table is full, every other entry is dropped and the interval is
+/// doubled, so a song of any length fits in kMaxEntries at the cost of a
+/// coarser interval.
+class SeekTable
+{
+ public:
+  static constexpr size_t kMaxEntries = 128;
+
+  /// A position in a song.
+  struct Position_t
+  {
+    /// File offset of the position.
+    uint32_t offset;
+    /// Playback time at the offset.
+    std::chrono::milliseconds time;
+  };
+
+  /// Empties the table.
+  ///
+  /// @param format Header of the song's first frame.
+  /// @param frames_per_entry Number of frames between entries.
+  void Reset(const FrameHeader_t & format, uint32_t frames_per_entry)
+  {
+    samples_per_frame_ = format.samples_per_frame;
+    sample_rate_       = format.sample_rate;
+    frames_per_entry_  = std::max<uint32_t>(frames_per_entry, 1);
+    frame_count_       = 0;
+    count_             = 0;
+    is_complete_       = false;
+  }
+
+  /// Records the next frame of the song, frames must be added in order.
+  ///
+  /// @param offset File offset of the frame's header.
+  void AddFrame(uint32_t offset)
+  {
+    if (frame_count_ % frames_per_entry_ == 0)
+    {
+      Append(offset);
+    }
+    frame_count_++;
+  }
+
+  /// Records the next entry directly, for tables taken from a song's table of
+  /// contents rather than built frame by frame.
+  ///
+  /// @param offset File offset at or just before the entry's first frame.
+  void AddEntry(uint32_t offset)
+  {
+    Append(offset);
+    frame_count_ += frames_per_entry_;
+  }
+
+  /// Marks the table as covering the whole song.
+  void Finish()
+  {
+    is_complete_ = true;
+  }
+
+  /// Finds the entry at or before a playback time.
+  ///
+  /// @returns The entry, or std::nullopt if the time is past the part of the
+  ///          song the table covers so far.
+  std::optional<Position_t> Find(std::chrono::milliseconds time) const
+  {
+    if (count_ == 0 || time.count() < 0)
+    {
+      return std::nullopt;
+    }
+
+    const uint64_t kFrame = static_cast<uint64_t>(time.count()) *
+                            sample_rate_ / (1000 * samples_per_frame_);
+    const size_t kEntry = static_cast<size_t>(kFrame / frames_per_entry_);
+    if (kEntry >= count_ && !is_complete_)
+    {
+      return std::nullopt;
+    }
+
+    const size_t kIndex = std::min(kEntry, count_ - 1);
+    return Position_t{
+      .offset = offsets_[kIndex],
+      .time   = GetFrameTime(uint64_t{ kIndex } * frames_per_entry_),
+    };
+  }
+
+  /// @returns The playback time at the start of a frame.
+  std::chrono::milliseconds GetFrameTime(uint64_t frame) const
+  {
+    if (sample_rate_ == 0)
+    {
+      return 0ms;
+    }
+    return std::chrono::milliseconds(frame * samples_per_frame_ * 1000 /
+                                     sample_rate_);
+  }
+
+  /// @returns Number of entries in the table.
+  size_t GetCount() const
+  {
+    return count_;
+  }
+
+  /// @returns True if the table covers the whole song.
+  bool IsComplete() const
+  {
+    return is_complete_;
+  }
+
+ private:
+  void Append(uint32_t offset)
+  {
+    if (count_ == kMaxEntries)
+    {
+      // Keep the even entries, whose frames stay on the doubled interval.
+      for (size_t i = 0; i < kMaxEntries / 2; i++)
+      {
+        offsets_[i] = offsets_[2 * i];
+      }
+      count_ = kMaxEntries / 2;
+      frames_per_entry_ *= 2;
+    }
+    offsets_[count_++] = offset;
+  }
+
+  std::array<uint32_t, kMaxEntries> offsets_;
+  uint32_t samples_per_frame_ = 0;
+  uint32_t sample_rate_       = 0;
+  uint32_t frames_per_entry_  = 1;
+  /// Number of frames added.
+  uint32_t frame_count_ = 0;
+  size_t count_         = 0;
+  bool is_complete_     = false;
+};
+}  // namespace mp3
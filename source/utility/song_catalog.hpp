@@ -0,0 +1,169 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "library_index.hpp"
+#include "song_handle.hpp"
+
+namespace mp3
+{
+/// A cursor over the songs of the library index that keeps only a window of
+/// kWindowSize songs in RAM.
+///
+/// Accessing a song outside the window pages in the kWindowSize songs around
+/// it, one index record each, so memory use is fixed no matter how many songs
+/// the library holds. Songs are held as handles along with the details needed
+/// to list them, not their paths.
+///
+/// The window is placed a quarter of its size behind the song that caused the
+/// page, so stepping back a few songs after paging does not page again.
+///
+/// @tparam kWindowSize Number of songs kept in RAM.
+template <size_t kWindowSize>
+class SongCatalog
+{
+ public:
+  static_assert(kWindowSize >= 2, "The window must hold at least 2 songs.");
+
+  /// A song of the window.
+  struct Song_t
+  {
+    SongHandle_t handle;
+    /// Size of the file in bytes.
+    uint32_t file_size;
+    /// Estimated duration in milliseconds.
+    uint32_t duration;
+  };
+
+  explicit SongCatalog(LibraryIndex & library) : library_(library) {}
+
+  /// @returns Number of songs in the library.
+  size_t GetCount() const
+  {
+    return library_.GetCount();
+  }
+
+  /// @returns The song at an index, or nullptr if the index is past the end
+  ///          of the library or the song could not be read. The song remains
+  ///          valid until the next call that pages the window.
+  const Song_t * Get(size_t index)
+  {
+    if (index >= GetCount())
+    {
+      return nullptr;
+    }
+    if (index < window_start_ || index >= window_start_ + window_count_)
+    {
+      Page(index);
+    }
+    if (index >= window_start_ + window_count_)
+    {
+      return nullptr;
+    }
+    return &window_[index - window_start_];
+  }
+
+  /// @returns Index of the song under the cursor.
+  size_t GetPosition() const
+  {
+    return position_;
+  }
+
+  /// @returns The song under the cursor.
+  const Song_t * GetCurrent()
+  {
+    return Get(position_);
+  }
+
+  /// Moves the cursor to a song.
+  ///
+  /// @returns The song, or nullptr if the index is past the end of the
+  ///          library.
+  const Song_t * Seek(size_t index)
+  {
+    if (index >= GetCount())
+    {
+      return nullptr;
+    }
+    position_ = index;
+    return GetCurrent();
+  }
+
+  /// Moves the cursor to the next song, wrapping around to the first.
+  const Song_t * Next()
+  {
+    const size_t kCount = GetCount();
+    if (kCount == 0)
+    {
+      return nullptr;
+    }
+    position_ = (position_ + 1) % kCount;
+    return GetCurrent();
+  }
+
+  /// Moves the cursor to the previous song, wrapping around to the last.
+  const Song_t * Previous()
+  {
+    const size_t kCount = GetCount();
+    if (kCount == 0)
+    {
+      return nullptr;
+    }
+    position_ = (position_ == 0 || position_ >= kCount) ? kCount - 1
+                                                        : position_ - 1;
+    return GetCurrent();
+  }
+
+  /// Discards the window, to be called when the library index changes. The
+  /// cursor keeps its position, clamped to the new end of the library.
+  void Invalidate()
+  {
+    window_start_ = 0;
+    window_count_ = 0;
+    if (position_ >= GetCount())
+    {
+      position_ = 0;
+    }
+  }
+
+ private:
+  void Page(size_t index)
+  {
+    const size_t kCount = GetCount();
+    size_t start        = (index > kWindowSize / 4) ? index - kWindowSize / 4
+                                                    : 0;
+    if (kCount > kWindowSize && start > kCount - kWindowSize)
+    {
+      start = kCount - kWindowSize;
+    }
+
+    window_start_ = start;
+    window_count_ = 0;
+    while (window_count_ < kWindowSize && start + window_count_ < kCount)
+    {
+      const size_t kIndex = start + window_count_;
+      const auto * entry  = library_.Read(kIndex);
+      if (entry == nullptr)
+      {
+        break;
+      }
+      window_[window_count_++] = Song_t{
+        .handle    = library_.GetHandle(kIndex),
+        .file_size = entry->file_size,
+        .duration  = entry->metadata.duration,
+      };
+    }
+  }
+
+  LibraryIndex & library_;
+  std::array<Song_t, kWindowSize> window_;
+  /// Index of the first song in the window.
+  size_t window_start_ = 0;
+  /// Number of songs in the window.
+  size_t window_count_ = 0;
+  /// Index of the song under the cursor.
+  size_t position_ = 0;
+};
+}  // namespace mp3
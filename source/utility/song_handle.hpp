@@ -0,0 +1,121 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "L3_Application/task_scheduler.hpp"
+
+namespace mp3
+{
+/// A reference to a song, small enough to be passed through queues by value.
+/// The song's path is only looked up when the song is opened.
+///
+/// A handle records the generation of the table it refers to. When the table
+/// is rebuilt and its entries renumbered, the generation changes so that an
+/// older handle never resolves to a different song.
+struct SongHandle_t
+{
+  enum class Source : uint8_t
+  {
+    kNone,
+    /// A record of the LibraryIndex.
+    kLibrary,
+    /// A slot of a PathTable.
+    kPathTable,
+  };
+
+  Source source       = Source::kNone;
+  uint8_t reserved    = 0;
+  uint16_t generation = 0;
+  /// Index of the record or slot holding the song's path.
+  uint32_t index = 0;
+
+  bool operator==(const SongHandle_t & other) const
+  {
+    return source == other.source && generation == other.generation &&
+           index == other.index;
+  }
+};
+static_assert(std::is_trivially_copyable_v<SongHandle_t>);
+static_assert(sizeof(SongHandle_t) == 8);
+
+/// Interned paths of songs played by path rather than from the library, such
+/// as the files of the playback benchmark.
+///
+/// Slots are reused in turn, so a path stays valid until kSlotCount more paths
+/// have been added. Sizing the table for more songs than can be queued at once
+/// ensures a queued song's path is never overwritten.
+///
+/// @tparam kSlotCount Number of paths held at once.
+template <size_t kSlotCount>
+class PathTable
+{
+ public:
+  PathTable()
+  {
+    mutex_ = xSemaphoreCreateMutexStatic(&mutex_buffer_);
+  }
+
+  /// Copies a path into the next slot.
+  ///
+  /// @returns A handle to the path.
+  SongHandle_t Add(const char * path)
+  {
+    xSemaphoreTake(mutex_, portMAX_DELAY);
+    const size_t kIndex = next_slot_;
+    next_slot_          = (next_slot_ + 1) % kSlotCount;
+
+    Slot_t & slot = slots_[kIndex];
+    slot.generation++;
+    std::strncpy(slot.path, path, sizeof(slot.path) - 1);
+    slot.path[sizeof(slot.path) - 1] = '\0';
+
+    const SongHandle_t kHandle = {
+      .source     = SongHandle_t::Source::kPathTable,
+      .reserved   = 0,
+      .generation = slot.generation,
+      .index      = static_cast<uint32_t>(kIndex),
+    };
+    xSemaphoreGive(mutex_);
+    return kHandle;
+  }
+
+  /// Copies the path of a handle made by Add().
+  ///
+  /// @returns False if the slot has since been reused.
+  bool GetPath(const SongHandle_t & song, char * path, size_t length) const
+  {
+    if (song.source != SongHandle_t::Source::kPathTable ||
+        song.index >= kSlotCount || length == 0)
+    {
+      return false;
+    }
+
+    xSemaphoreTake(mutex_, portMAX_DELAY);
+    const Slot_t & slot  = slots_[song.index];
+    const bool kIsLatest = (slot.generation == song.generation);
+    if (kIsLatest)
+    {
+      std::strncpy(path, slot.path, length - 1);
+      path[length - 1] = '\0';
+    }
+    xSemaphoreGive(mutex_);
+    return kIsLatest;
+  }
+
+ private:
+  struct Slot_t
+  {
+    uint16_t generation = 0;
+    char path[256]      = "";
+  };
+
+  std::array<Slot_t, kSlotCount> slots_;
+  size_t next_slot_ = 0;
+  StaticSemaphore_t mutex_buffer_;
+  SemaphoreHandle_t mutex_;
+};
+}  // namespace mp3
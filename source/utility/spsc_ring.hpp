@@ -0,0 +1,107 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+
+/// A lock-free ring buffer for exactly one producer and one consumer, such as
+/// a task feeding data to an interrupt service routine.
+///
+/// @tparam T The element type.
+template <typename T>
+class SpscRing
+{
+ public:
+  /// Copies as many elements as will fit into the ring. Must only be called
+  /// by the producer.
+  ///
+  /// @param data Elements to push.
+  /// @param count Number of elements to push.
+  /// @returns The number of elements pushed.
+  size_t Push(const T * data, size_t count)
+  {
+    const size_t kHead = head_.load(std::memory_order_relaxed);
+    const size_t kTail = tail_.load(std::memory_order_acquire);
+    count              = std::min(count, capacity_ - (kHead - kTail));
+
+    for (size_t i = 0; i < count; i++)
+    {
+      storage_[(kHead + i) & mask_] = data[i];
+    }
+    head_.store(kHead + count, std::memory_order_release);
+    return count;
+  }
+
+  /// Copies up to `count` elements out of the ring. Must only be called by the
+  /// consumer.
+  ///
+  /// @param data Destination for the popped elements.
+  /// @param count Maximum number of elements to pop.
+  /// @returns The number of elements popped.
+  size_t Pop(T * data, size_t count)
+  {
+    const size_t kTail = tail_.load(std::memory_order_relaxed);
+    const size_t kHead = head_.load(std::memory_order_acquire);
+    count              = std::min(count, kHead - kTail);
+
+    for (size_t i = 0; i < count; i++)
+    {
+      data[i] = storage_[(kTail + i) & mask_];
+    }
+    tail_.store(kTail + count, std::memory_order_release);
+    return count;
+  }
+
+  /// @returns The number of elements currently in the ring.
+  size_t GetSize() const
+  {
+    return head_.load(std::memory_order_acquire) -
+           tail_.load(std::memory_order_acquire);
+  }
+
+  /// @returns The number of elements that can be pushed.
+  size_t GetAvailable() const
+  {
+    return capacity_ - GetSize();
+  }
+
+  /// @returns The maximum number of elements the ring can hold.
+  size_t GetCapacity() const
+  {
+    return capacity_;
+  }
+
+ protected:
+  /// @param storage Backing storage of the ring.
+  /// @param capacity Number of elements in the storage, must be a power of 2.
+  SpscRing(T * storage, size_t capacity)
+      : storage_(storage), capacity_(capacity), mask_(capacity - 1)
+  {
+  }
+
+ private:
+  T * const storage_;
+  const size_t capacity_;
+  const size_t mask_;
+  /// Free running indices, only the producer writes head_ and only the
+  /// consumer writes tail_.
+  std::atomic<size_t> head_ = 0;
+  std::atomic<size_t> tail_ = 0;
+};
+
+/// A SpscRing backed by statically allocated storage.
+///
+/// @tparam T The element type.
+/// @tparam kCapacity Number of elements, must be a power of 2.
+template <typename T, size_t kCapacity>
+class StaticSpscRing final : public SpscRing<T>
+{
+ public:
+  static_assert(kCapacity > 0 && (kCapacity & (kCapacity - 1)) == 0,
+                "Capacity must be a power of 2.");
+
+  StaticSpscRing() : SpscRing<T>(storage_, kCapacity) {}
+
+ private:
+  T storage_[kCapacity];
+};
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "L3_Application/task_scheduler.hpp"
+
+/// A FreeRTOS queue whose storage is held by the object, so the queue is
+/// allocated along with its owner rather than from the FreeRTOS heap.
+///
+/// @tparam T Type of the queue's items.
+/// @tparam kLength Maximum number of items in the queue.
+template <typename T, size_t kLength>
+class StaticQueue
+{
+ public:
+  StaticQueue()
+  {
+    handle_ = xQueueCreateStatic(kLength, sizeof(T), storage_.data(), &queue_);
+  }
+
+  StaticQueue(const StaticQueue &) = delete;
+  StaticQueue & operator=(const StaticQueue &) = delete;
+
+  /// @returns The handle to pass to the FreeRTOS queue functions.
+  QueueHandle_t GetHandle() const
+  {
+    return handle_;
+  }
+
+ private:
+  std::array<uint8_t, kLength * sizeof(T)> storage_;
+  StaticQueue_t queue_;
+  QueueHandle_t handle_;
+};
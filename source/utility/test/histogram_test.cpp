@@ -0,0 +1,61 @@
+#include "L4_Testing/testing_frameworks.hpp"
+
+#include "../histogram.hpp"
+
+TEST_CASE("Testing LatencyHistogram")
+{
+  LatencyHistogram<4> histogram;
+
+  SECTION("Bucket limits double from the first bucket's")
+  {
+    CHECK(histogram.GetBucketLimit(0) == 64us);
+    CHECK(histogram.GetBucketLimit(1) == 128us);
+    CHECK(histogram.GetBucketLimit(2) == 256us);
+    CHECK(histogram.GetBucketCount() == 4);
+  }
+
+  SECTION("Samples are counted in the bucket below their limit")
+  {
+    histogram.Record(0us);
+    histogram.Record(63us);
+    histogram.Record(64us);
+    histogram.Record(127us);
+    histogram.Record(128us);
+    histogram.Record(255us);
+
+    CHECK(histogram.GetBucket(0) == 2);
+    CHECK(histogram.GetBucket(1) == 2);
+    CHECK(histogram.GetBucket(2) == 2);
+    CHECK(histogram.GetBucket(3) == 0);
+  }
+
+  SECTION("The last bucket counts every sample beyond its range")
+  {
+    histogram.Record(256us);
+    histogram.Record(1'000'000us);
+
+    CHECK(histogram.GetBucket(3) == 2);
+    CHECK(histogram.GetMax() == 1'000'000us);
+  }
+
+  SECTION("Count, average and maximum cover every sample")
+  {
+    histogram.Record(100us);
+    histogram.Record(300us);
+
+    CHECK(histogram.GetCount() == 2);
+    CHECK(histogram.GetAverage() == 200us);
+    CHECK(histogram.GetMax() == 300us);
+  }
+
+  SECTION("Reset() clears every bucket and counter")
+  {
+    histogram.Record(100us);
+    histogram.Reset();
+
+    CHECK(histogram.GetCount() == 0);
+    CHECK(histogram.GetBucket(1) == 0);
+    CHECK(histogram.GetAverage() == 0us);
+    CHECK(histogram.GetMax() == 0us);
+  }
+}
@@ -0,0 +1,197 @@
+#include <cstdio>
+#include <cstring>
+
+#include "L4_Testing/testing_frameworks.hpp"
+
+#include "../library_index.hpp"
+#include "ram_storage.hpp"
+#include "song_file.hpp"
+
+namespace
+{
+/// Writes a song of silent frames followed by an ID3v1 tag holding its title.
+void WriteSong(const char * path, const char * title, size_t frame_count)
+{
+  song_file::Bytes song;
+  song_file::AppendSilentFrames(&song, frame_count);
+  const size_t kTagStart = song.size();
+  song_file::AppendText(&song, "TAG");
+  song_file::AppendText(&song, title);
+  song.resize(kTagStart + mp3::Id3v1_t::kSize, 0);
+  song_file::Write(path, song);
+}
+
+void VerifyAll(mp3::LibraryIndex * library)
+{
+  while (!library->Update())
+  {
+    continue;
+  }
+}
+
+/// @returns Index of the song with the path, or SIZE_MAX if it is not in the
+///          library.
+size_t Find(mp3::LibraryIndex * library, const char * path)
+{
+  for (size_t i = 0; i < library->GetCount(); i++)
+  {
+    const mp3::LibraryIndex::Entry_t * entry = library->Read(i);
+    if (entry != nullptr && std::strcmp(entry->path, path) == 0)
+    {
+      return i;
+    }
+  }
+  return SIZE_MAX;
+}
+}  // namespace
+
+TEST_CASE("Testing LibraryIndex")
+{
+  FATFS fat_fs;
+  GetRamDisk().Format();
+  REQUIRE(GetRamDisk().Mount(&fat_fs));
+
+  f_mkdir("/album");
+  f_mkdir("/album/disc");
+  WriteSong("/first.mp3", "First", 4);
+  WriteSong("/album/second.mp3", "Second", 4);
+  WriteSong("/album/disc/third.mp3", "Third", 4);
+  WriteSong("/notes.txt", "", 1);
+
+  mp3::LibraryIndex library;
+  REQUIRE(library.Open());
+  VerifyAll(&library);
+
+  SECTION("Songs in subdirectories are recorded by their path")
+  {
+    CHECK(library.IsVerified());
+    REQUIRE(library.GetCount() == 3);
+    CHECK(Find(&library, "/first.mp3") != SIZE_MAX);
+    CHECK(Find(&library, "/album/second.mp3") != SIZE_MAX);
+    CHECK(Find(&library, "/album/disc/third.mp3") != SIZE_MAX);
+    CHECK(Find(&library, "/notes.txt") == SIZE_MAX);
+
+    const size_t kThird = Find(&library, "/album/disc/third.mp3");
+    const mp3::SongHandle_t kSong = library.GetHandle(kThird);
+    char path[64];
+    mp3::Metadata_t metadata = {};
+    REQUIRE(library.GetPath(kSong, path, sizeof(path)));
+    CHECK(std::strcmp(path, "/album/disc/third.mp3") == 0);
+    REQUIRE(library.GetMetadata(kSong, &metadata));
+    CHECK(std::strcmp(metadata.title, "Third") == 0);
+    CHECK(metadata.duration > 0);
+  }
+
+  SECTION("Reopening the index keeps its records without rebuilding")
+  {
+    library.Close();
+    mp3::LibraryIndex reopened;
+    REQUIRE(reopened.Open());
+    CHECK(reopened.GetCount() == 3);
+
+    VerifyAll(&reopened);
+
+    FILINFO info;
+    CHECK(f_stat(mp3::LibraryIndex::kRebuildPath, &info) == FR_NO_FILE);
+    CHECK(reopened.GetCount() == 3);
+  }
+
+  SECTION("Added, changed and removed songs are found when verifying")
+  {
+    const mp3::SongHandle_t kFirst =
+        library.GetHandle(Find(&library, "/first.mp3"));
+    const mp3::SongHandle_t kSecond =
+        library.GetHandle(Find(&library, "/album/second.mp3"));
+    library.Close();
+    f_unlink("/first.mp3");
+    WriteSong("/album/disc/third.mp3", "Changed", 8);
+    WriteSong("/album/fourth.mp3", "Fourth", 4);
+
+    REQUIRE(library.Open());
+    VerifyAll(&library);
+
+    REQUIRE(library.GetCount() == 3);
+    CHECK(Find(&library, "/first.mp3") == SIZE_MAX);
+    CHECK(Find(&library, "/album/second.mp3") != SIZE_MAX);
+    CHECK(Find(&library, "/album/fourth.mp3") != SIZE_MAX);
+    const size_t kThird = Find(&library, "/album/disc/third.mp3");
+    REQUIRE(kThird != SIZE_MAX);
+    CHECK(std::strcmp(library.Read(kThird)->metadata.title, "Changed") == 0);
+
+    // Handles made before the rebuild resolve through the previous index,
+    // and are remapped to the song's new record unless it was removed.
+    char path[64];
+    REQUIRE(library.GetPath(kSecond, path, sizeof(path)));
+    CHECK(std::strcmp(path, "/album/second.mp3") == 0);
+    mp3::SongHandle_t second = kSecond;
+    REQUIRE(library.Remap(&second));
+    CHECK(second.generation == library.GetGeneration());
+    CHECK(second.index == Find(&library, "/album/second.mp3"));
+    mp3::SongHandle_t first = kFirst;
+    CHECK_FALSE(library.Remap(&first));
+
+    // The rebuilt index replaced the old one, which is kept until the next
+    // rebuild.
+    FILINFO info;
+    CHECK(f_stat(mp3::LibraryIndex::kRebuildPath, &info) == FR_NO_FILE);
+    CHECK(f_stat(mp3::LibraryIndex::kPreviousPath, &info) == FR_OK);
+    library.Close();
+    mp3::LibraryIndex reopened;
+    REQUIRE(reopened.Open());
+    CHECK(reopened.GetCount() == 3);
+  }
+
+  SECTION("Songs moved further than kRemapDistance are treated as removed")
+  {
+    const mp3::SongHandle_t kSecond =
+        library.GetHandle(Find(&library, "/album/second.mp3"));
+    const mp3::SongHandle_t kThird =
+        library.GetHandle(Find(&library, "/album/disc/third.mp3"));
+    library.Close();
+    // Songs in /album/disc are walked after third.mp3 and before second.mp3.
+    for (size_t i = 0; i <= mp3::LibraryIndex::kRemapDistance; i++)
+    {
+      char path[32];
+      std::snprintf(path, sizeof(path), "/album/disc/new%zu.mp3", i);
+      WriteSong(path, "New", 1);
+    }
+
+    REQUIRE(library.Open());
+    VerifyAll(&library);
+
+    mp3::SongHandle_t third = kThird;
+    CHECK(library.Remap(&third));
+    mp3::SongHandle_t second = kSecond;
+    CHECK_FALSE(library.Remap(&second));
+  }
+
+  SECTION("The index is kept as it was if it cannot be rebuilt")
+  {
+    library.Close();
+    WriteSong("/album/fourth.mp3", "Fourth", 4);
+    // A directory in its place keeps the rebuilt index from being created.
+    REQUIRE(f_mkdir(mp3::LibraryIndex::kRebuildPath) == FR_OK);
+
+    REQUIRE(library.Open());
+    VerifyAll(&library);
+
+    CHECK(library.GetCount() == 3);
+    CHECK(Find(&library, "/album/fourth.mp3") == SIZE_MAX);
+    library.Close();
+    mp3::LibraryIndex reopened;
+    REQUIRE(reopened.Open());
+    CHECK(reopened.GetCount() == 3);
+    CHECK(Find(&reopened, "/album/second.mp3") != SIZE_MAX);
+  }
+
+  SECTION("An index left renamed by an interrupted replacement is restored")
+  {
+    library.Close();
+    REQUIRE(f_rename(mp3::LibraryIndex::kIndexPath,
+                     mp3::LibraryIndex::kPreviousPath) == FR_OK);
+
+    REQUIRE(library.Open());
+
+    CHECK(library.GetCount() == 3);
+  }
+}
@@ -0,0 +1,267 @@
+#include <cstring>
+
+#include "L4_Testing/testing_frameworks.hpp"
+
+#include "../metadata_parser.hpp"
+#include "ram_storage.hpp"
+#include "song_file.hpp"
+
+namespace
+{
+using song_file::AppendBigEndian;
+using song_file::AppendSilentFrames;
+using song_file::AppendLittleEndian;
+using song_file::AppendText;
+using song_file::Bytes;
+
+constexpr const char * kSongPath = "/song.mp3";
+
+/// Appends a size as 4 bytes of 7 bits each.
+void AppendSynchsafe(Bytes * bytes, uint32_t value)
+{
+  for (int shift = 21; shift >= 0; shift -= 7)
+  {
+    bytes->push_back(static_cast<uint8_t>((value >> shift) & 0x7F));
+  }
+}
+
+/// Appends an ID3v2 frame, whose size is synchsafe in ID3v2.4 only.
+void AppendFrame(Bytes * bytes,
+                 uint8_t version,
+                 const char * identifier,
+                 const Bytes & payload)
+{
+  AppendText(bytes, identifier, 4);
+  if (version == 4)
+  {
+    AppendSynchsafe(bytes, static_cast<uint32_t>(payload.size()));
+  }
+  else
+  {
+    AppendBigEndian(bytes, static_cast<uint32_t>(payload.size()));
+  }
+  bytes->push_back(0);
+  bytes->push_back(0);
+  bytes->insert(bytes->end(), payload.begin(), payload.end());
+}
+
+/// Appends an ISO-8859-1 text frame.
+void AppendTextFrame(Bytes * bytes,
+                     uint8_t version,
+                     const char * identifier,
+                     const char * text)
+{
+  Bytes payload = { 0 };
+  AppendText(&payload, text);
+  AppendFrame(bytes, version, identifier, payload);
+}
+
+/// Appends an ID3v2 tag holding the frames followed by padding.
+///
+/// @returns Offset of the first byte after the tag.
+size_t AppendId3v2(Bytes * bytes,
+                   uint8_t version,
+                   uint8_t flags,
+                   const Bytes & frames,
+                   size_t padding)
+{
+  AppendText(bytes, "ID3");
+  bytes->push_back(version);
+  bytes->push_back(0);
+  bytes->push_back(flags);
+  AppendSynchsafe(bytes, static_cast<uint32_t>(frames.size() + padding));
+  bytes->insert(bytes->end(), frames.begin(), frames.end());
+  bytes->insert(bytes->end(), padding, 0);
+  return bytes->size();
+}
+
+/// Appends an ID3v1 tag with space padded fields.
+void AppendId3v1(Bytes * bytes,
+                 const char * title,
+                 const char * artist,
+                 const char * album)
+{
+  const size_t kStart = bytes->size();
+  AppendText(bytes, "TAG");
+  for (const char * field : { title, artist, album })
+  {
+    AppendText(bytes, field);
+    bytes->insert(bytes->end(), 30 - std::strlen(field), ' ');
+  }
+  bytes->resize(kStart + mp3::Id3v1_t::kSize, 0);
+}
+
+/// Appends an APEv2 tag with a header and a single item.
+void AppendApe(Bytes * bytes)
+{
+  constexpr uint32_t kHasHeaderFlag = 1U << 31;
+  constexpr uint32_t kIsHeaderFlag  = 1U << 29;
+  Bytes item;
+  AppendLittleEndian(&item, 5);
+  AppendLittleEndian(&item, 0);
+  AppendText(&item, "Title");
+  item.push_back(0);
+  AppendText(&item, "Hello");
+  // Excludes the header.
+  const uint32_t kSize = static_cast<uint32_t>(item.size() + 32);
+
+  for (const bool kIsHeader : { true, false })
+  {
+    const uint32_t kFlags = kHasHeaderFlag | (kIsHeader ? kIsHeaderFlag : 0);
+    AppendText(bytes, "APETAGEX");
+    AppendLittleEndian(bytes, 2000);
+    AppendLittleEndian(bytes, kSize);
+    AppendLittleEndian(bytes, 1);
+    AppendLittleEndian(bytes, kFlags);
+    bytes->insert(bytes->end(), 8, 0);
+    if (kIsHeader)
+    {
+      bytes->insert(bytes->end(), item.begin(), item.end());
+    }
+  }
+}
+
+mp3::Metadata_t Parse(const Bytes & bytes)
+{
+  mp3::Metadata_t metadata = {};
+  FIL file;
+  if (!song_file::Write(kSongPath, bytes))
+  {
+    return metadata;
+  }
+
+  mp3::MetadataParser parser;
+  if (f_open(&file, kSongPath, FA_READ) == FR_OK)
+  {
+    parser.Parse(&file, &metadata);
+    f_close(&file);
+  }
+  return metadata;
+}
+}  // namespace
+
+TEST_CASE("Testing MetadataParser")
+{
+  FATFS fat_fs;
+  GetRamDisk().Format();
+  REQUIRE(GetRamDisk().Mount(&fat_fs));
+
+  Bytes song;
+  Bytes frames;
+
+  SECTION("ID3v2.3 frame sizes are plain integers")
+  {
+    // Read as a synchsafe size, the private frame's size would be wrong and
+    // the frames after it would be missed.
+    AppendFrame(&frames, 3, "PRIV", Bytes(200, 0x55));
+    AppendTextFrame(&frames, 3, "TIT2", "Title");
+    AppendTextFrame(&frames, 3, "TPE1", "Artist");
+    AppendTextFrame(&frames, 3, "TALB", "Album");
+    AppendTextFrame(&frames, 3, "TLEN", "123456");
+    const size_t kAudioStart = AppendId3v2(&song, 3, 0, frames, 64);
+    AppendSilentFrames(&song, 4);
+
+    const mp3::Metadata_t kMetadata = Parse(song);
+
+    CHECK(std::strcmp(kMetadata.title, "Title") == 0);
+    CHECK(std::strcmp(kMetadata.artist, "Artist") == 0);
+    CHECK(std::strcmp(kMetadata.album, "Album") == 0);
+    CHECK(kMetadata.duration == 123456);
+    CHECK(kMetadata.audio_start == kAudioStart);
+    CHECK(kMetadata.audio_end == song.size());
+  }
+
+  SECTION("ID3v2.4 sizes are synchsafe and a footer ends the tag")
+  {
+    constexpr uint8_t kExtendedHeaderFlag = 1 << 6;
+    constexpr uint8_t kFooterFlag         = 1 << 4;
+    // The extended header's size is synchsafe and includes itself.
+    AppendSynchsafe(&frames, 6);
+    frames.push_back(1);
+    frames.push_back(0);
+    AppendFrame(&frames, 4, "PRIV", Bytes(200, 0x55));
+    AppendTextFrame(&frames, 4, "TIT2", "Title");
+    AppendId3v2(&song, 4, kExtendedHeaderFlag | kFooterFlag, frames, 0);
+    AppendText(&song, "3DI");
+    song.resize(song.size() + 7, 0);
+    const size_t kAudioStart = song.size();
+    AppendSilentFrames(&song, 4);
+
+    const mp3::Metadata_t kMetadata = Parse(song);
+
+    CHECK(std::strcmp(kMetadata.title, "Title") == 0);
+    CHECK(kMetadata.audio_start == kAudioStart);
+  }
+
+  SECTION("UTF-16 text is converted to ASCII")
+  {
+    // "Café" with a little endian byte order mark.
+    const Bytes kTitle = { 1,   0xFF, 0xFE, 'C', 0, 'a', 0,
+                           'f', 0,    0xE9, 0,   0, 0 };
+    AppendFrame(&frames, 3, "TIT2", kTitle);
+    AppendId3v2(&song, 3, 0, frames, 0);
+    AppendSilentFrames(&song, 1);
+
+    const mp3::Metadata_t kMetadata = Parse(song);
+
+    CHECK(std::strcmp(kMetadata.title, "Caf?") == 0);
+  }
+
+  SECTION("The attached picture is located without being read")
+  {
+    AppendFrame(&frames, 3, "APIC", Bytes(1000, 0xAA));
+    AppendId3v2(&song, 3, 0, frames, 0);
+    AppendSilentFrames(&song, 1);
+
+    const mp3::Metadata_t kMetadata = Parse(song);
+
+    CHECK(kMetadata.picture_offset == 10 + 10);
+    CHECK(kMetadata.picture_size == 1000);
+  }
+
+  SECTION("Fields missing from the ID3v2 tag come from the ID3v1 tag")
+  {
+    AppendTextFrame(&frames, 3, "TIT2", "Title");
+    const size_t kAudioStart = AppendId3v2(&song, 3, 0, frames, 0);
+    AppendSilentFrames(&song, 4);
+    const size_t kAudioEnd = song.size();
+    AppendId3v1(&song, "Other", "Artist", "Album");
+
+    const mp3::Metadata_t kMetadata = Parse(song);
+
+    CHECK(std::strcmp(kMetadata.title, "Title") == 0);
+    CHECK(std::strcmp(kMetadata.artist, "Artist") == 0);
+    CHECK(std::strcmp(kMetadata.album, "Album") == 0);
+    CHECK(kMetadata.audio_start == kAudioStart);
+    CHECK(kMetadata.audio_end == kAudioEnd);
+  }
+
+  SECTION("An APE tag before the ID3v1 tag is excluded from the audio")
+  {
+    AppendSilentFrames(&song, 4);
+    const size_t kAudioEnd = song.size();
+    AppendApe(&song);
+    AppendId3v1(&song, "Title", "", "");
+
+    const mp3::Metadata_t kMetadata = Parse(song);
+
+    CHECK(std::strcmp(kMetadata.title, "Title") == 0);
+    CHECK(kMetadata.audio_start == 0);
+    CHECK(kMetadata.audio_end == kAudioEnd);
+  }
+
+  SECTION("Unsynchronised tags are skipped and left to the ID3v1 tag")
+  {
+    constexpr uint8_t kUnsynchronisationFlag = 1 << 7;
+    AppendTextFrame(&frames, 3, "TIT2", "Title");
+    const size_t kAudioStart =
+        AppendId3v2(&song, 3, kUnsynchronisationFlag, frames, 0);
+    AppendSilentFrames(&song, 1);
+    AppendId3v1(&song, "Fallback", "", "");
+
+    const mp3::Metadata_t kMetadata = Parse(song);
+
+    CHECK(std::strcmp(kMetadata.title, "Fallback") == 0);
+    CHECK(kMetadata.audio_start == kAudioStart);
+  }
+}
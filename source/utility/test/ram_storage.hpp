@@ -0,0 +1,159 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "L2_HAL/memory/sd.hpp"
+#include "L3_Application/fatfs.hpp"
+
+/// Storage held in RAM for host tests, standing in for the SD card so that
+/// code using FatFs can be tested against a real file system.
+///
+/// The storage holds a FAT12 volume with an empty root directory, written by
+/// Format() without FatFs so that it does not depend on FF_USE_MKFS.
+///
+/// @tparam kBlockCount Number of 512 byte blocks.
+template <size_t kBlockCount>
+class RamStorage final : public sjsu::Storage
+{
+ public:
+  /// Size of a block, in bytes, matching the SD card.
+  static constexpr size_t kBlockSize = 512;
+
+  static_assert(kBlockCount >= 128 && kBlockCount <= 4000,
+                "The volume must be large enough for FatFs to mount and "
+                "small enough to be FAT12.");
+
+  RamStorage()
+  {
+    Format();
+  }
+
+  /// Erases the storage and writes an empty volume.
+  void Format()
+  {
+    blocks_ = {};
+
+    // Boot sector with the BIOS parameter block, one sector per cluster.
+    uint8_t * boot = &blocks_[0];
+    boot[0]        = 0xEB;
+    boot[1]        = 0x3C;
+    boot[2]        = 0x90;
+    std::memcpy(&boot[3], "MSWIN4.1", 8);
+    SetWord(&boot[11], kBlockSize);
+    boot[13] = 1;
+    SetWord(&boot[14], kReservedBlocks);
+    boot[16] = 1;
+    SetWord(&boot[17], kRootEntryCount);
+    SetWord(&boot[19], kBlockCount);
+    boot[21] = kMediaType;
+    SetWord(&boot[22], kFatBlocks);
+    boot[38] = 0x29;
+    std::memcpy(&boot[43], "NO NAME    ", 11);
+    std::memcpy(&boot[54], "FAT12   ", 8);
+    boot[510] = 0x55;
+    boot[511] = 0xAA;
+
+    // The first two FAT entries hold the media type and the end of chain
+    // marker.
+    uint8_t * fat = &blocks_[kReservedBlocks * kBlockSize];
+    fat[0]        = kMediaType;
+    fat[1]        = 0xFF;
+    fat[2]        = 0xFF;
+  }
+
+  /// Registers the storage as the first FatFs drive and mounts it.
+  ///
+  /// @param fat_fs Work area of the mounted volume.
+  /// @returns True if the volume was mounted.
+  bool Mount(FATFS * fat_fs)
+  {
+    if (!is_registered_)
+    {
+      is_registered_ = sjsu::RegisterFatFsDrive(this);
+    }
+    return is_registered_ && f_mount(fat_fs, "", 1) == FR_OK;
+  }
+
+  Type GetMemoryType() override
+  {
+    return Type::kRam;
+  }
+
+  void Initialize() override {}
+
+  bool IsMediaPresent() override
+  {
+    return true;
+  }
+
+  void Enable() override {}
+
+  bool IsReadOnly() override
+  {
+    return false;
+  }
+
+  units::data::byte_t GetCapacity() override
+  {
+    return units::data::byte_t(static_cast<double>(blocks_.size()));
+  }
+
+  units::data::byte_t GetBlockSize() override
+  {
+    return units::data::byte_t(kBlockSize);
+  }
+
+  void Erase(uint32_t, size_t) override {}
+
+  void Write(uint32_t block_address, const void * data, size_t size) override
+  {
+    if (IsInRange(block_address, size))
+    {
+      std::memcpy(&blocks_[block_address * kBlockSize], data, size);
+    }
+  }
+
+  void Read(uint32_t block_address, void * data, size_t size) override
+  {
+    if (IsInRange(block_address, size))
+    {
+      std::memcpy(data, &blocks_[block_address * kBlockSize], size);
+    }
+  }
+
+  void Disable() override {}
+
+ private:
+  static constexpr size_t kReservedBlocks = 1;
+  static constexpr size_t kRootEntryCount = 512;
+  static constexpr uint8_t kMediaType     = 0xF8;
+  /// FAT12 takes 1.5 bytes per cluster, and there are fewer clusters than
+  /// blocks.
+  static constexpr size_t kFatBlocks =
+      ((kBlockCount + 2) * 3 / 2 + kBlockSize - 1) / kBlockSize;
+
+  static void SetWord(uint8_t * data, size_t value)
+  {
+    data[0] = static_cast<uint8_t>(value);
+    data[1] = static_cast<uint8_t>(value >> 8);
+  }
+
+  bool IsInRange(uint32_t block_address, size_t size) const
+  {
+    return block_address * kBlockSize + size <= blocks_.size();
+  }
+
+  std::array<uint8_t, kBlockCount * kBlockSize> blocks_;
+  bool is_registered_ = false;
+};
+
+/// The RAM disk shared by the host tests. FatFs drives cannot be unregistered,
+/// so every test formats and mounts this one storage as the first drive.
+inline RamStorage<1024> & GetRamDisk()
+{
+  static RamStorage<1024> ram_disk;
+  return ram_disk;
+}
@@ -0,0 +1,158 @@
+#include "L4_Testing/testing_frameworks.hpp"
+
+#include "../seek_index.hpp"
+#include "ram_storage.hpp"
+#include "song_file.hpp"
+
+namespace
+{
+using song_file::AppendBigEndian;
+using song_file::AppendText;
+using song_file::Bytes;
+using song_file::kFrameHeader;
+using song_file::kFrameLength;
+
+constexpr const char * kSongPath = "/song.mp3";
+/// Side information of a MPEG-1 stereo frame, which the Xing and VBRI headers
+/// follow.
+constexpr size_t kSideInfoSize = 32;
+/// Bytes before the first frame, which the tables are offset from.
+constexpr size_t kLeadIn = 10;
+/// Number of frames between entries of a table built by walking the frames,
+/// about a second.
+constexpr uint32_t kFramesPerSecond = 44'100 / 1152;
+
+const mp3::SongHandle_t kSong = {
+  .source = mp3::SongHandle_t::Source::kPathTable,
+  .index  = 1,
+};
+
+/// Starts a song with kLeadIn bytes of zeros and the header and side
+/// information of its first frame.
+Bytes BeginSong()
+{
+  Bytes song(kLeadIn, 0);
+  song.insert(song.end(), kFrameHeader.begin(), kFrameHeader.end());
+  song.insert(song.end(), kSideInfoSize, 0);
+  return song;
+}
+
+/// Pads the song's last frame to its full length.
+void EndFrame(Bytes * song)
+{
+  song->resize(kLeadIn + ((song->size() - kLeadIn + kFrameLength - 1) /
+                          kFrameLength) *
+                             kFrameLength,
+               0);
+}
+
+/// Builds the table of the song, reading it from the RAM disk.
+mp3::SeekTable BuildTable(const Bytes & song)
+{
+  song_file::Write(kSongPath, song);
+
+  mp3::SeekIndex index;
+  index.Request(kSong, kSongPath, 0, static_cast<uint32_t>(song.size()));
+  while (!index.Update())
+  {
+    continue;
+  }
+
+  mp3::SeekTable table;
+  index.Get(kSong, &table);
+  return table;
+}
+}  // namespace
+
+TEST_CASE("Testing SeekIndex")
+{
+  FATFS fat_fs;
+  GetRamDisk().Format();
+  REQUIRE(GetRamDisk().Mount(&fat_fs));
+
+  SECTION("The table is taken from a Xing header's table of contents")
+  {
+    constexpr uint32_t kFrameCount = 40 * kFramesPerSecond;
+    constexpr uint32_t kBytes      = kFrameCount * kFrameLength;
+    constexpr uint32_t kFlags      = 0b111;
+    Bytes song                     = BeginSong();
+    AppendText(&song, "Xing");
+    AppendBigEndian(&song, kFlags, 4);
+    AppendBigEndian(&song, kFrameCount, 4);
+    AppendBigEndian(&song, kBytes, 4);
+    // Entry i is the offset of i percent of the song, in 1/256ths of its
+    // size.
+    for (uint32_t i = 0; i < 100; i++)
+    {
+      song.push_back(static_cast<uint8_t>(i * 256 / 100));
+    }
+    EndFrame(&song);
+
+    const mp3::SeekTable kTable = BuildTable(song);
+
+    CHECK(kTable.IsComplete());
+    const auto kStart = kTable.Find(0ms);
+    REQUIRE(kStart);
+    CHECK(kStart->offset == kLeadIn);
+    // A quarter of the song is at entry 25, 64/256ths in.
+    const auto kQuarter =
+        kTable.Find(kTable.GetFrameTime(kFrameCount / 4) + 1ms);
+    REQUIRE(kQuarter);
+    CHECK(kQuarter->offset == kLeadIn + kBytes / 4);
+    CHECK(kQuarter->time == kTable.GetFrameTime(kFrameCount / 4));
+  }
+
+  SECTION("The table is taken from a VBRI header's table of contents")
+  {
+    const uint32_t kPartSizes[] = { 1000, 2000, 3000, 4000 };
+    constexpr uint32_t kScale   = 2;
+    Bytes song                  = BeginSong();
+    AppendText(&song, "VBRI");
+    // Version, delay and quality.
+    AppendBigEndian(&song, 1, 2);
+    AppendBigEndian(&song, 0, 2);
+    AppendBigEndian(&song, 75, 2);
+    // Bytes and frames of the song, not used for the table.
+    AppendBigEndian(&song, 0, 4);
+    AppendBigEndian(&song, 0, 4);
+    // Entry count, scale, entry size and frames per entry.
+    AppendBigEndian(&song, 4, 2);
+    AppendBigEndian(&song, kScale, 2);
+    AppendBigEndian(&song, 2, 2);
+    AppendBigEndian(&song, kFramesPerSecond, 2);
+    for (uint32_t size : kPartSizes)
+    {
+      AppendBigEndian(&song, size / kScale, 2);
+    }
+    EndFrame(&song);
+    song.resize(song.size() + 10'000, 0);
+
+    const mp3::SeekTable kTable = BuildTable(song);
+
+    CHECK(kTable.IsComplete());
+    CHECK(kTable.GetCount() == 4);
+    // Parts start after the VBRI frame.
+    const auto kStart = kTable.Find(0ms);
+    REQUIRE(kStart);
+    CHECK(kStart->offset == kLeadIn + kFrameLength);
+    const auto kThird =
+        kTable.Find(kTable.GetFrameTime(2 * kFramesPerSecond) + 1ms);
+    REQUIRE(kThird);
+    CHECK(kThird->offset == kLeadIn + kFrameLength + 1000 + 2000);
+  }
+
+  SECTION("Without a table of contents, the frames are walked")
+  {
+    Bytes song(kLeadIn, 0);
+    song_file::AppendSilentFrames(&song, 3 * kFramesPerSecond);
+
+    const mp3::SeekTable kTable = BuildTable(song);
+
+    CHECK(kTable.IsComplete());
+    CHECK(kTable.GetCount() == 3);
+    const auto kSecond =
+        kTable.Find(kTable.GetFrameTime(kFramesPerSecond) + 1ms);
+    REQUIRE(kSecond);
+    CHECK(kSecond->offset == kLeadIn + kFramesPerSecond * kFrameLength);
+  }
+}
@@ -0,0 +1,117 @@
+#include "L4_Testing/testing_frameworks.hpp"
+
+#include "../seek_table.hpp"
+
+namespace
+{
+// A 128 kbps MPEG-1 frame at 44.1 kHz lasts 1152 / 44100 s, about 26 ms, and
+// takes 417 bytes.
+constexpr uint32_t kFrameLength = 417;
+
+mp3::FrameHeader_t MakeFormat()
+{
+  return mp3::FrameHeader_t{
+    .bitrate           = 128'000,
+    .sample_rate       = 44'100,
+    .samples_per_frame = 1152,
+    .length            = kFrameLength,
+    .is_mpeg1          = true,
+    .is_mono           = false,
+  };
+}
+
+uint32_t GetFrameOffset(uint32_t frame)
+{
+  return 100 + frame * kFrameLength;
+}
+}  // namespace
+
+TEST_CASE("Testing SeekTable")
+{
+  mp3::SeekTable table;
+
+  SECTION("An empty table finds nothing")
+  {
+    table.Reset(MakeFormat(), 1);
+
+    CHECK_FALSE(table.Find(0ms));
+  }
+
+  SECTION("Find() returns the entry at or before the time")
+  {
+    table.Reset(MakeFormat(), 10);
+    for (uint32_t frame = 0; frame < 100; frame++)
+    {
+      table.AddFrame(GetFrameOffset(frame));
+    }
+
+    CHECK(table.GetCount() == 10);
+    const auto kStart = table.Find(0ms);
+    REQUIRE(kStart);
+    CHECK(kStart->offset == GetFrameOffset(0));
+    CHECK(kStart->time == 0ms);
+
+    // 653 ms is the end of frame 24, which falls in the entry of frame 20.
+    const auto kMiddle = table.Find(653ms);
+    REQUIRE(kMiddle);
+    CHECK(kMiddle->offset == GetFrameOffset(20));
+    CHECK(kMiddle->time == table.GetFrameTime(20));
+    CHECK(kMiddle->time == 522ms);
+
+    CHECK_FALSE(table.Find(-1ms));
+  }
+
+  SECTION("Times past the part built so far are only found once finished")
+  {
+    table.Reset(MakeFormat(), 10);
+    for (uint32_t frame = 0; frame < 30; frame++)
+    {
+      table.AddFrame(GetFrameOffset(frame));
+    }
+
+    CHECK_FALSE(table.IsComplete());
+    CHECK_FALSE(table.Find(10'000ms));
+
+    table.Finish();
+
+    CHECK(table.IsComplete());
+    const auto kEnd = table.Find(10'000ms);
+    REQUIRE(kEnd);
+    CHECK(kEnd->offset == GetFrameOffset(20));
+  }
+
+  SECTION("A full table drops every other entry and doubles the interval")
+  {
+    table.Reset(MakeFormat(), 1);
+    for (uint32_t frame = 0; frame <= mp3::SeekTable::kMaxEntries; frame++)
+    {
+      table.AddFrame(GetFrameOffset(frame));
+    }
+
+    CHECK(table.GetCount() == mp3::SeekTable::kMaxEntries / 2 + 1);
+    // Frame times are rounded down, so 1 ms into a frame is within it.
+    for (uint32_t frame : { 0, 2, 10, 100, 128 })
+    {
+      const auto kEntry = table.Find(table.GetFrameTime(frame) + 1ms);
+      REQUIRE(kEntry);
+      CHECK(kEntry->offset == GetFrameOffset(frame));
+    }
+    // Odd frames now fall back to the frame before them.
+    const auto kOdd = table.Find(table.GetFrameTime(11) + 1ms);
+    REQUIRE(kOdd);
+    CHECK(kOdd->offset == GetFrameOffset(10));
+  }
+
+  SECTION("Entries can be added directly from a table of contents")
+  {
+    table.Reset(MakeFormat(), 38);
+    table.AddEntry(1000);
+    table.AddEntry(2000);
+    table.Finish();
+
+    const auto kSecond = table.Find(table.GetFrameTime(40));
+    REQUIRE(kSecond);
+    CHECK(kSecond->offset == 2000);
+    CHECK(kSecond->time == table.GetFrameTime(38));
+  }
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "L3_Application/fatfs.hpp"
+
+/// Helpers for the host tests to build song files byte by byte and write them
+/// to the RAM disk.
+namespace song_file
+{
+using Bytes = std::vector<uint8_t>;
+
+/// Header of a 128 kbps MPEG-1 joint stereo frame at 44.1 kHz.
+constexpr std::array<uint8_t, 4> kFrameHeader = { 0xFF, 0xFB, 0x90, 0x64 };
+/// Length of a frame with kFrameHeader, in bytes.
+constexpr size_t kFrameLength = 417;
+
+inline void AppendText(Bytes * bytes, const char * text, size_t length)
+{
+  bytes->insert(bytes->end(), text, text + length);
+}
+
+inline void AppendText(Bytes * bytes, const char * text)
+{
+  AppendText(bytes, text, std::strlen(text));
+}
+
+/// Appends the low `length` bytes of a value, most significant first.
+inline void AppendBigEndian(Bytes * bytes, uint32_t value, size_t length = 4)
+{
+  for (size_t i = length; i > 0; i--)
+  {
+    bytes->push_back(static_cast<uint8_t>(value >> ((i - 1) * 8)));
+  }
+}
+
+inline void AppendLittleEndian(Bytes * bytes, uint32_t value)
+{
+  for (int shift = 0; shift < 32; shift += 8)
+  {
+    bytes->push_back(static_cast<uint8_t>(value >> shift));
+  }
+}
+
+/// Appends frames of kFrameLength bytes holding a header followed by silence.
+inline void AppendSilentFrames(Bytes * bytes, size_t frame_count)
+{
+  for (size_t i = 0; i < frame_count; i++)
+  {
+    bytes->insert(bytes->end(), kFrameHeader.begin(), kFrameHeader.end());
+    bytes->insert(bytes->end(), kFrameLength - kFrameHeader.size(), 0);
+  }
+}
+
+/// Writes a file, replacing any file at the path.
+///
+/// @returns True if the whole file was written.
+inline bool Write(const char * path, const Bytes & bytes)
+{
+  FIL file;
+  UINT count = 0;
+  if (f_open(&file, path, FA_WRITE | FA_CREATE_ALWAYS) != FR_OK)
+  {
+    return false;
+  }
+  const bool kIsWritten =
+      f_write(&file, bytes.data(), static_cast<UINT>(bytes.size()), &count) ==
+          FR_OK &&
+      count == bytes.size();
+  return f_close(&file) == FR_OK && kIsWritten;
+}
+}  // namespace song_file
@@ -0,0 +1,64 @@
+#include <array>
+
+#include "L4_Testing/testing_frameworks.hpp"
+
+#include "../spsc_ring.hpp"
+
+TEST_CASE("Testing SpscRing")
+{
+  StaticSpscRing<int, 4> ring;
+  std::array<int, 8> output = {};
+
+  SECTION("An empty ring has nothing to pop")
+  {
+    CHECK(ring.GetCapacity() == 4);
+    CHECK(ring.GetSize() == 0);
+    CHECK(ring.GetAvailable() == 4);
+    CHECK(ring.Pop(output.data(), output.size()) == 0);
+  }
+
+  SECTION("Elements are popped in the order they were pushed")
+  {
+    const int kInput[] = { 1, 2, 3 };
+
+    CHECK(ring.Push(kInput, 3) == 3);
+    CHECK(ring.GetSize() == 3);
+    CHECK(ring.GetAvailable() == 1);
+
+    CHECK(ring.Pop(output.data(), 2) == 2);
+    CHECK(output[0] == 1);
+    CHECK(output[1] == 2);
+    CHECK(ring.GetSize() == 1);
+  }
+
+  SECTION("Push() stops at the capacity")
+  {
+    const int kInput[] = { 1, 2, 3, 4, 5, 6 };
+
+    CHECK(ring.Push(kInput, 6) == 4);
+    CHECK(ring.GetAvailable() == 0);
+    CHECK(ring.Push(kInput, 1) == 0);
+
+    CHECK(ring.Pop(output.data(), output.size()) == 4);
+    CHECK(output[3] == 4);
+  }
+
+  SECTION("Elements wrap around the end of the storage")
+  {
+    const int kFirst[]  = { 1, 2, 3 };
+    const int kSecond[] = { 4, 5, 6 };
+
+    ring.Push(kFirst, 3);
+    ring.Pop(output.data(), 2);
+    // Two elements land at the end of the storage and one at its start.
+    CHECK(ring.Push(kSecond, 3) == 3);
+    CHECK(ring.GetSize() == 4);
+
+    CHECK(ring.Pop(output.data(), output.size()) == 4);
+    CHECK(output[0] == 3);
+    CHECK(output[1] == 4);
+    CHECK(output[2] == 5);
+    CHECK(output[3] == 6);
+    CHECK(ring.GetSize() == 0);
+  }
+}